@@ -0,0 +1,23 @@
+// arena.h
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Single-block bump allocator. Everything allocated from it is released
+// together by arenaFree.
+typedef struct {
+    unsigned char* base;
+    size_t size;
+    size_t used;
+} MapArena;
+
+// Rounds a size up to the arena's 16-byte allocation granularity
+size_t arenaAlignSize(size_t size);
+
+bool arenaInit(MapArena* arena, size_t size);
+void* arenaAlloc(MapArena* arena, size_t size);
+void arenaFree(MapArena* arena);
+
+#endif
@@ -0,0 +1,55 @@
+// background.h
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#include "raylib.h"
+
+typedef enum {
+    BACKGROUND_QUALITY_OFF = 0,     // Flat SPACE_BG_COLOR, no shader at all
+    BACKGROUND_QUALITY_LOW,
+    BACKGROUND_QUALITY_MEDIUM,
+    BACKGROUND_QUALITY_HIGH,
+    BACKGROUND_QUALITY_COUNT
+} BackgroundQuality;
+
+typedef struct {
+    const char* name;
+    float scale;            // Fraction of the window resolution rendered
+    float updateRate;       // Nebula frames per second, cross-faded between
+    int octaves;            // Noise octaves per fbm layer (the shader does up to 6)
+} BackgroundTier;
+
+// Animated nebula behind the map. shaders/stars.fs is run into a small
+// offscreen target on its own clock and upscaled; the last two frames are
+// cross-faded so the low update rate does not show.
+typedef struct {
+    Shader shader;
+    bool shaderReady;
+    int timeLoc;
+    int screenWidthLoc;
+    int screenHeightLoc;
+    int octavesLoc;
+
+    RenderTexture2D targets[2];     // Previous and current nebula frame
+    int current;
+    int width;                      // Size of the targets, 0 when none
+    int height;
+
+    BackgroundQuality quality;
+    double lastUpdate;              // Time the current frame was rendered
+    bool primed;                    // Both targets hold a frame
+} Background;
+
+Background* loadBackground(BackgroundQuality quality);
+void unloadBackground(Background* background);
+
+void setBackgroundQuality(Background* background, BackgroundQuality quality);
+const BackgroundTier* getBackgroundTier(BackgroundQuality quality);
+
+// Renders a new nebula frame when one is due; call outside BeginDrawing
+void updateBackground(Background* background, double time);
+
+// Fills the window: clears to the base color, then upscales the nebula
+void drawBackground(const Background* background, double time);
+
+#endif
@@ -0,0 +1,23 @@
+// country_search.h
+#ifndef COUNTRY_SEARCH_H
+#define COUNTRY_SEARCH_H
+
+#include "map_utils.h"
+
+#define COUNTRY_SEARCH_MAX_RESULTS 8
+
+// Prefix index over country names, every word in them and ISO codes, kept
+// as one sorted array of lowercase keys. A query is a binary search for the
+// first key with the prefix followed by a scan of the matching run.
+typedef struct CountrySearch CountrySearch;
+
+CountrySearch* buildCountrySearch(const WorldMap* map);
+void unloadCountrySearch(CountrySearch* search);
+
+// Fills results with up to maxResults distinct country indices whose name,
+// a word of the name or ISO code starts with prefix, ignoring case. ISO
+// codes and name starts come before matches further into a name; each group
+// is alphabetical. Returns the number found.
+int searchCountries(const CountrySearch* search, const char* prefix, int* results, int maxResults);
+
+#endif
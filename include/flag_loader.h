@@ -0,0 +1,49 @@
+// flag_loader.h
+#ifndef FLAG_LOADER_H
+#define FLAG_LOADER_H
+
+#include "map_utils.h"
+
+// Box the info panel shows a flag in, and the size flags are rasterized to
+#define FLAG_MAX_WIDTH 60
+#define FLAG_MAX_HEIGHT 40
+
+#define FLAG_UPLOADS_PER_FRAME 2
+#define FLAG_LOADER_WORKERS 2
+#define FLAG_CACHE_DIR "flag_cache"
+#define FLAG_CACHE_MAGIC "TTFL"
+#define FLAG_CACHE_VERSION 1
+
+// Flags live in square RGBA atlas pages, packed in shelves with a clear
+// border around each. A page holds 60 to 90 flags; the default is 4 pages.
+#define FLAG_ATLAS_SIZE 512
+#define FLAG_ATLAS_PADDING 1
+#define FLAG_ATLAS_MAX_PAGES 16
+#define FLAG_ATLAS_DEFAULT_BUDGET (4 * 1024 * 1024)
+
+// Loads assets/flags/<iso>.svg in the background; on the web, where flags
+// are not bundled, they are fetched over HTTP and kept in IndexedDB. Workers
+// rasterize the SVG with nanosvg to fit the display box and keep the pixels
+// in FLAG_CACHE_DIR under a hash of the file, so later runs skip the
+// rasterizer. The main thread copies a few finished flags per frame into the
+// atlas. Once the budget is used up, the least recently drawn page is
+// cleared and repacked, and its flags are loaded again when next requested.
+typedef struct FlagLoader FlagLoader;
+
+// cacheDir may be NULL to rasterize every time; budgetBytes <= 0 uses
+// FLAG_ATLAS_DEFAULT_BUDGET and is rounded down to whole pages (at least one)
+FlagLoader* loadFlagLoader(const WorldMap* map, const char* cacheDir, long budgetBytes);
+void unloadFlagLoader(FlagLoader* loader);
+
+// Queues the country's flag unless it is loaded, pending or known missing
+void requestCountryFlag(FlagLoader* loader, const WorldMap* map, int countryIndex);
+
+// Copies up to FLAG_UPLOADS_PER_FRAME finished flags into the atlas; call
+// outside BeginDrawing
+void updateFlagLoader(FlagLoader* loader, const WorldMap* map);
+
+// The atlas page and the rectangle on it holding the country's flag, at
+// display size. False until the flag is loaded. Marks the page as used.
+bool getCountryFlag(FlagLoader* loader, int countryIndex, Texture2D* texture, Rectangle* source);
+
+#endif
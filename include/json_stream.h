@@ -0,0 +1,46 @@
+// json_stream.h
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define JSON_STREAM_BUFFER_SIZE 65536
+
+// Pull-style JSON tokenizer. It reads from a file through a fixed buffer or
+// from a block of memory, and never builds a tree: callers walk objects and
+// arrays with jsonNextKey/jsonNextElement and skip whatever they don't need.
+// Any syntax error sets `failed`, after which every call returns false.
+typedef struct {
+    FILE* file;
+    char* buffer;           // Owned read buffer when streaming from a file
+    const char* data;
+    size_t length;
+    size_t pos;
+    size_t consumed;        // Bytes consumed before the current buffer
+    bool failed;
+} JsonStream;
+
+bool jsonStreamOpenFile(JsonStream* s, const char* filename);
+void jsonStreamOpenMemory(JsonStream* s, const char* data, size_t length);
+void jsonStreamClose(JsonStream* s);
+
+// Next non-whitespace character without consuming it, or -1 at the end
+int jsonPeek(JsonStream* s);
+bool jsonExpect(JsonStream* s, char c);
+
+// Object/array iteration: the opening bracket must already be consumed.
+// `first` starts true; returns false after consuming the closing bracket.
+bool jsonNextKey(JsonStream* s, bool* first, char* key, size_t keySize);
+bool jsonNextElement(JsonStream* s, bool* first);
+
+// Reads a string (truncated to outSize - 1 bytes), a number or any value
+bool jsonReadString(JsonStream* s, char* out, size_t outSize);
+bool jsonReadNumber(JsonStream* s, double* value);
+bool jsonSkipValue(JsonStream* s);
+
+// Reads a string value into `out`, or skips a non-string value and clears it
+bool jsonReadOptionalString(JsonStream* s, char* out, size_t outSize);
+
+#endif
@@ -0,0 +1,47 @@
+// map_builder.h
+#ifndef MAP_BUILDER_H
+#define MAP_BUILDER_H
+
+#include "map_utils.h"
+#include "thread_pool.h"
+
+// Accumulates countries, polygons and points while a loader walks its
+// source. Ring points are appended straight onto WorldMap.points; the
+// finished map and its simplified levels (map_lod.h) are packed into a
+// single arena by mapBuilderFinish.
+typedef struct {
+    WorldMap* map;
+    int countryCapacity;
+    int polygonCapacity;
+    int pointCapacity;
+    int triangleCapacity;
+    int committedPoints;    // Points owned by committed polygons
+    int* scratch;           // Triangulation work space
+    int scratchCapacity;
+    ThreadPool* pool;       // Optional, spreads mapBuilderFinish's work
+} MapBuilder;
+
+bool mapBuilderInit(MapBuilder* builder);
+
+// Starts a new ring, dropping any points of a ring that was not committed
+void mapBuilderBeginRing(MapBuilder* builder);
+bool mapBuilderAddPoint(MapBuilder* builder, Vector2 point);
+
+// Turns the current ring into a polygon: bounds and triangles are computed
+// here, the owner is assigned by mapBuilderEndFeature.
+bool mapBuilderCommitRing(MapBuilder* builder);
+
+// Assigns polygons from firstPolygon on to the named country, or removes
+// them again when the feature turned out to be unusable (valid == false).
+bool mapBuilderEndFeature(MapBuilder* builder, int firstPolygon, const char* name, const char* isoCode, bool valid);
+
+// Appends everything another builder collected, merging its countries
+// into this one's by name. Loaders that split a source into chunks build
+// each chunk separately and append them in source order.
+bool mapBuilderAppend(MapBuilder* builder, const MapBuilder* chunk);
+
+// Packs the map into its arena and returns it; the builder is then empty
+WorldMap* mapBuilderFinish(MapBuilder* builder);
+void mapBuilderAbort(MapBuilder* builder);
+
+#endif
@@ -0,0 +1,63 @@
+// map_file.h
+#ifndef MAP_FILE_H
+#define MAP_FILE_H
+
+#include "map_utils.h"
+#include <stdint.h>
+
+// Compiled map produced by `make mapdata`. Sections are stored in host byte
+// order and 8-byte aligned, with the same layout as WorldMap's arrays, so a
+// loaded file is used in place and nothing is allocated per polygon.
+#define MAP_FILE_MAGIC "TTMP"
+#define MAP_FILE_VERSION 3
+#define MAP_FILE_BYTE_ORDER 0x01020304u
+#define MAP_FILE_EXTENSION ".ttmap"
+
+typedef struct {
+    float tolerance;
+    uint32_t pointCount;
+    uint32_t triangleIndexCount;
+    uint32_t reserved;
+    uint64_t polygonsOffset;    // Polygon[polygonCount]
+    uint64_t pointsOffset;      // Vector2[pointCount]
+    uint64_t trianglesOffset;   // int[triangleIndexCount]
+} MapFileLevel;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;         // MAP_FILE_BYTE_ORDER as written by the compiler
+    uint32_t checksum;          // FNV-1a of everything after the header, see verifyWorldMapFile
+    uint64_t fileSize;
+    uint64_t sourceSize;        // Size of the GeoJSON it was compiled from
+    uint32_t countryCount;
+    uint32_t polygonCount;
+    uint32_t pointCount;
+    uint32_t triangleIndexCount;
+    uint64_t countriesOffset;   // Country[countryCount]
+    uint64_t polygonsOffset;    // Polygon[polygonCount]
+    uint64_t boundsOffset;      // PolygonBounds[polygonCount]
+    uint64_t ownersOffset;      // int[polygonCount]
+    uint64_t pointsOffset;      // Vector2[pointCount]
+    uint64_t trianglesOffset;   // int[triangleIndexCount], polygon-local indices
+    MapFileLevel levels[MAP_LOD_LEVELS - 1];  // Simplified levels 1.., see map_lod.h
+} MapFileHeader;
+
+// Swaps the extension of a GeoJSON path for MAP_FILE_EXTENSION
+void getMapFilePath(const char* sourcePath, char* out, int outSize);
+
+// Returns NULL when the file is missing, stale, corrupt or from another
+// version, so the caller can fall back to the GeoJSON source. Only the
+// header, section ranges and polygon tables are checked, so the geometry
+// pages stay untouched until they are drawn.
+WorldMap* loadWorldMapFile(const char* filename, const char* sourcePath);
+bool saveWorldMapFile(const WorldMap* map, const char* filename, const char* sourcePath);
+
+// Full check including the checksum over every section; run by the map
+// compiler rather than at startup
+bool verifyWorldMapFile(const char* filename);
+
+// Releases the mapping that backs a map loaded by loadWorldMapFile
+void unmapWorldMapFile(WorldMap* map);
+
+#endif
@@ -0,0 +1,42 @@
+// map_layer.h
+#ifndef MAP_LAYER_H
+#define MAP_LAYER_H
+
+#include "map_utils.h"
+#include "map_mesh.h"
+
+// Pans up to this fraction of the layer size reuse the previous drawing
+#define MAP_LAYER_MAX_SHIFT 0.5f
+
+// Retained map drawing. The map is rendered into a texture only when the
+// view, selection, statuses or window size change; small integer pans copy
+// the previous texture shifted and redraw just the newly exposed strips.
+// Two targets are kept so the shift can read one while writing the other.
+typedef struct {
+    RenderTexture2D targets[2];
+    int current;            // Target holding the up-to-date layer
+    bool valid;             // False until drawn, and after invalidateMapLayer
+    int width;
+    int height;
+
+    // State the current target was drawn with
+    Vector2 offset;
+    float zoom;
+    int selectedCountry;    // Country index, -1 for none
+    unsigned int statusVersion;
+} MapLayer;
+
+MapLayer* loadMapLayer(int width, int height);
+void unloadMapLayer(MapLayer* layer);
+
+// Forces a full redraw on the next update
+void invalidateMapLayer(MapLayer* layer);
+
+// Brings the texture up to date; call outside BeginDrawing. mesh may be NULL,
+// in which case the CPU polygon renderer is used.
+void updateMapLayer(MapLayer* layer, WorldMap* map, MapMesh* mesh, int selectedCountry, CountryStatusList* statusList);
+
+// One textured quad covering the window
+void drawMapLayer(const MapLayer* layer);
+
+#endif
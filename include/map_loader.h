@@ -0,0 +1,21 @@
+// map_loader.h
+#ifndef MAP_LOADER_H
+#define MAP_LOADER_H
+
+#include "map_utils.h"
+
+// Loads the world map on its own thread so the window can draw a progress
+// screen meanwhile. Without threads the load runs inside startMapLoad and
+// is finished by the first poll.
+typedef struct MapLoader MapLoader;
+
+MapLoader* startMapLoad(const char* filename);
+
+// Current stage name and progress from 0 to 1; true once the load is over
+bool pollMapLoad(MapLoader* loader, const char** stage, float* progress);
+
+// Waits for the load and frees the loader. Returns the map, or NULL if it
+// failed, and the time the load took in milliseconds.
+WorldMap* finishMapLoad(MapLoader* loader, double* milliseconds);
+
+#endif
@@ -0,0 +1,23 @@
+// map_lod.h
+#ifndef MAP_LOD_H
+#define MAP_LOD_H
+
+#include "map_utils.h"
+#include "thread_pool.h"
+
+// Builds levels 1.. of map->levels from the full-resolution geometry with
+// Douglas-Peucker. Vertices where the set of polygons sharing them changes
+// (border junctions) are locked, and every chain between two of them is
+// simplified in a canonical direction, so a border shared by two countries
+// simplifies identically on both sides and no gaps open up between them.
+// Level arrays are malloc'd; the map builder packs them into its arena.
+// Polygons are simplified in parallel on the pool (which may be NULL); the
+// result does not depend on the number of threads.
+bool buildMapLevels(WorldMap* map, ThreadPool* pool);
+void freeMapLevels(WorldMap* map);
+
+// Picks the coarsest level whose tolerance stays under one screen pixel
+int selectMapLevel(const WorldMap* map, float zoom);
+int selectMapLevelForScale(const WorldMap* map, float degreesPerPixel);
+
+#endif
@@ -0,0 +1,54 @@
+// map_mesh.h
+#ifndef MAP_MESH_H
+#define MAP_MESH_H
+
+#include "map_utils.h"
+
+// Mesh chunks are limited by raylib's 16-bit index buffers
+#define MAP_MESH_MAX_VERTICES 65535
+
+// Border widths in screen pixels
+#define MAP_OUTLINE_WIDTH 1.0f
+#define MAP_SELECTED_OUTLINE_WIDTH 2.5f
+
+// Static GPU copy of the world fill. Vertices stay in lon/lat and the camera
+// is applied in shaders/map.vs, so panning and zooming never touch geometry.
+// Each vertex samples its country's color from a countryCount x 1 texture.
+typedef struct {
+    Mesh* meshes;
+    int meshCount;
+    int levelStart[MAP_LOD_LEVELS + 1];    // Chunks of each level of detail
+    Material material;
+    Texture2D colorTexture;
+    Color* colors;          // CPU copy of colorTexture, one texel per country
+    int countryCount;
+    int zoomLoc;
+    int offsetLoc;
+    int screenSizeLoc;
+
+    // Borders as quads widened in shaders/outline.vs, an edge shared by two
+    // countries stored once, so all borders take a few draws per level
+    Mesh* outlineMeshes;
+    int outlineMeshCount;
+    int outlineLevelStart[MAP_LOD_LEVELS + 1];
+    Material outlineMaterial;
+    int outlineZoomLoc;
+    int outlineOffsetLoc;
+    int outlineScreenSizeLoc;
+    int outlineHalfWidthLoc;
+
+    // Outline of the selected country alone, rebuilt when the selection changes
+    Mesh* selectionMeshes;
+    int selectionMeshCount;
+    int selectionLevelStart[MAP_LOD_LEVELS + 1];
+    int selectedCountry;
+} MapMesh;
+
+MapMesh* loadMapMesh(const WorldMap* map);
+void unloadMapMesh(MapMesh* mesh);
+void updateMapMeshColor(MapMesh* mesh, int countryIndex, Color color);
+void syncMapMeshColors(MapMesh* mesh, const WorldMap* map, int selectedCountry, CountryStatusList* statusList);
+void drawMapMesh(MapMesh* mesh, const WorldMap* map);
+void drawMapMeshOutlines(MapMesh* mesh, const WorldMap* map);
+
+#endif
@@ -0,0 +1,45 @@
+// map_tiles.h
+#ifndef MAP_TILES_H
+#define MAP_TILES_H
+
+#include "map_utils.h"
+
+// Deep zoom draws the map from a z/x/y pyramid of textures instead of
+// geometry. Level z cuts the world into 2^z x 2^z tiles with the window's
+// aspect; the level is picked so tiles are never magnified on screen.
+#define MAP_TILE_WIDTH 256
+#define MAP_TILE_HEIGHT 144
+#define MAP_TILE_MAX_LEVEL 7        // 128 x 128 tiles covers the 25x zoom limit
+#define MAP_TILES_MIN_ZOOM 4.0f     // Tiles render and draw from here; below, the map layer
+#define MAP_TILE_COARSE_LEVELS 2    // Fallback level rendered first, this many up
+#define MAP_TILE_UPLOADS_PER_FRAME 4
+#define MAP_TILE_WORKERS 2
+
+// Texture memory for cached tiles; overridden in megabytes by MAP_TILE_BUDGET_ENV.
+// Smaller budgets are raised to MAP_TILE_MIN_ENTRIES, the most tiles one
+// window can show (tiles are never magnified), about 5 MB.
+#define MAP_TILE_DEFAULT_BUDGET (64 * 1024 * 1024)
+#define MAP_TILE_MIN_ENTRIES ((SCREEN_WIDTH / MAP_TILE_WIDTH + 1) * (SCREEN_HEIGHT / MAP_TILE_HEIGHT + 1))
+#define MAP_TILE_BUDGET_ENV "TRAVELTINT_TILE_MB"
+
+// Tiles are rasterized on background threads (see raster.h) and uploaded
+// on the main thread a few per frame into an LRU cache that stays within
+// the memory budget. A status change restarts every tile in the background;
+// until a tile is current its stale texture, or the nearest cached ancestor,
+// is drawn in its place.
+typedef struct MapTiles MapTiles;
+
+// budgetBytes <= 0 uses MAP_TILE_BUDGET_ENV or MAP_TILE_DEFAULT_BUDGET.
+// The map must outlive the tiles.
+MapTiles* loadMapTiles(const WorldMap* map, long budgetBytes);
+void unloadMapTiles(MapTiles* tiles);
+
+// Uploads finished tiles and queues the ones the view needs; call every
+// frame outside BeginDrawing. Returns true when the view is at tile zoom
+// and every part of it has a texture to draw.
+bool updateMapTiles(MapTiles* tiles, const WorldMap* map, const CountryStatusList* statusList);
+
+// Textured quads for the view of the last update
+void drawMapTiles(const MapTiles* tiles, const WorldMap* map);
+
+#endif
@@ -4,13 +4,15 @@
 
 #include "raylib.h"
 #include "parson.h"
+#include "arena.h"
+#include <stddef.h>
 
 #define SCREEN_WIDTH 1280
 #define SCREEN_HEIGHT 720
-#define MAX_POINTS 1000
 
 #define DEFAULT_LAND_COLOR (Color){100, 130, 180, 255}  // Bluish color for countries
 #define SELECTED_COLOR (Color){180, 200, 255, 255}      // Lighter blue for selection
+#define SELECTED_OUTLINE_COLOR (Color){235, 245, 255, 255}
 #define SPACE_BG_COLOR (Color){10, 15, 30, 255}         // Dark blue for space background
 #define UI_PANEL_COLOR (Color){20, 25, 40, 230}    
 
@@ -32,20 +34,34 @@
 #define STATUS_LIVED 2
 #define STATUS_WANT 3
 
+// Level-of-detail pyramid: level 0 is the source geometry and each further
+// level allows four times the deviation (in degrees) of the previous one
+#define MAP_LOD_LEVELS 6
+#define MAP_LOD_TOLERANCES { 0.0f, 0.01f, 0.04f, 0.16f, 0.64f, 2.56f }
+
+// Two-letter ISO codes packed as (a - 'a') * 26 + (b - 'a')
+#define ISO_KEY_COUNT (26 * 26)
+
 typedef struct {
     char iso_code[3];
     int status;
 } CountryStatus;
 
+// statuses holds one entry per ISO key ever set, with the code lowercased,
+// for saving; lookups and updates go through the dense per-key tables
 typedef struct {
     CountryStatus* statuses;
     int count;
+    unsigned char statusByKey[ISO_KEY_COUNT];  // Dense copy of statuses for lookups
+    short entryByKey[ISO_KEY_COUNT];    // Index + 1 into statuses, 0 if unset
+    unsigned int version;   // Bumped on every change so cached drawings can tell
 } CountryStatusList;
 
 typedef struct {
-    Vector2* points;
+    int pointStart;     // Offset into WorldMap.points
     int numPoints;
-    Color color;
+    int triangleStart;  // Offset into WorldMap.triangles
+    int numTriangles;   // 3 polygon-local point indices each, built at load
 } Polygon;
 
 typedef struct {
@@ -56,42 +72,95 @@ typedef struct {
 typedef struct {
     char name[256];
     char iso_code[3];
+    int isoKey;         // Packed iso_code, or -1 if it is not two letters
     int polygonStart;
     int polygonCount;
-    Vector2* polygonPoints;
-    int pointCount;
 } Country;
 
+
 typedef struct {
-    Texture2D texture;
-    bool loaded;
-} CountryFlag;
+    float tolerance;        // Max deviation from the source outline, in degrees
+    Polygon* polygons;      // One per map polygon, ranges into the arrays below
+    Vector2* points;
+    int numPoints;
+    int* triangles;
+    int numTriangleIndices;
+} MapLevel;
 
+typedef struct SpatialGrid SpatialGrid;
+typedef struct MapPicker MapPicker;
 
+// Geometry is stored as flat arrays: polygons reference ranges of `points`
+// and `triangles`, with bounds and owners in parallel per-polygon arrays.
+// All of it lives in one arena block (or in the mapped compiled map).
 typedef struct {
     PolygonBounds* polygonBounds;
     Polygon* polygons;
+    int* polygonCountry;    // Owning country index for each polygon
     int numPolygons;
+    Vector2* points;
+    int numPoints;
+    int* triangles;
+    int numTriangleIndices;
+    MapLevel levels[MAP_LOD_LEVELS];  // levels[0] aliases polygons/points/triangles
     Country* countries;
     int countryCount;
+    MapArena arena;
     Vector2 offset;
     float zoom;
-    CountryFlag* flags;
+    Vector2* screenPoints;  // Scratch buffer sized for the largest polygon
+    SpatialGrid* spatialIndex;  // Built from polygonBounds at load
+    int* visiblePolygons;       // Query results, one slot per polygon
+    MapPicker* pickers[MAP_LOD_LEVELS];  // Click hit-testing per level, see picking.h
+    void* mappedFile;           // Compiled map backing the geometry, see map_file.h
+    size_t mappedSize;
 } WorldMap;
 
+static inline const Vector2* getPolygonPoints(const WorldMap* map, int index) {
+    return map->points + map->polygons[index].pointStart;
+}
+
+static inline const int* getPolygonTriangles(const WorldMap* map, int index) {
+    return map->triangles + map->polygons[index].triangleStart;
+}
+
+static inline const Vector2* getLevelPoints(const MapLevel* level, int index) {
+    return level->points + level->polygons[index].pointStart;
+}
+
+static inline const int* getLevelTriangles(const MapLevel* level, int index) {
+    return level->triangles + level->polygons[index].triangleStart;
+}
+
 float longitudeToScreenX(float longitude, float zoom, float offsetX);
 float latitudeToScreenY(float latitude, float zoom, float offsetY);
 WorldMap* loadWorldMap(const char* filename);
+
+// Called as loadWorldMapWithProgress moves through its stages, from the
+// loading thread or its pool workers; progress runs from 0 to 1
+typedef void (*MapLoadReport)(void* context, const char* stage, float progress);
+WorldMap* loadWorldMapWithProgress(const char* filename, MapLoadReport report, void* reportContext);
+WorldMap* loadWorldMapGeoJSON(const char* filename);  // Parallel, or streaming without threads
+WorldMap* loadWorldMapParson(const char* filename);   // Full parson DOM, kept for comparison
 void unloadWorldMap(WorldMap* map);
 
 
-void SaveCountryStatuses(const char* filename, CountryStatusList* list);
-CountryStatusList* LoadCountryStatuses(const char* filename);
 void UpdateCountryStatus(CountryStatusList* list, const char* iso_code, int status);
 int GetCountryStatus(CountryStatusList* list, const char* iso_code);
+int GetCountryStatusByKey(const CountryStatusList* list, int isoKey);
+int isoCodeKey(const char* iso_code);
 
 float screenXToLongitude(float screenX, float zoom, float offsetX);
 float screenYToLatitude(float screenY, float zoom, float offsetY);
-void drawWorldMap(WorldMap* map, const char* selectedCountry, CountryStatusList* statusList);
+// selectedCountry is a country index, or -1 for no selection
+void drawWorldMap(WorldMap* map, int selectedCountry, CountryStatusList* statusList);
+void drawWorldMapOutlines(WorldMap* map);
+// Same as above, limited to the polygons that overlap a screen rectangle
+void drawWorldMapArea(WorldMap* map, int selectedCountry, CountryStatusList* statusList, Rectangle area);
+// The selected look of one country alone, for drawing over the tile pyramid
+void drawWorldMapCountry(WorldMap* map, int countryIndex, CountryStatusList* statusList);
+// Union of the country's polygonBounds in lon/lat; empty if it has no geometry
+Rectangle getCountryBounds(const WorldMap* map, int countryIndex);
+Color getCountryColor(int status, bool isSelected);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+// picking.h
+#ifndef PICKING_H
+#define PICKING_H
+
+#include "map_utils.h"
+
+#define PICK_MAX_BUCKETS 64
+#define PICK_POINTS_PER_BUCKET 8
+
+// Point-in-polygon accelerator. Each polygon's latitude range is split into
+// horizontal bands and every band lists the edges that cross it, so a test
+// only looks at the handful of edges near the query latitude.
+struct MapPicker {
+    int* polygonFirstBucket;    // numPolygons + 1 offsets into bucketStart
+    int* bucketStart;           // Per bucket offset into bucketEdges
+    int* bucketEdges;           // Index of the edge's first point
+    int* candidates;            // Spatial query results, one slot per polygon
+};
+
+// Builds the accelerator for one level of detail; bands follow the full
+// resolution polygon bounds, which contain every level's outline
+MapPicker* buildMapPicker(const WorldMap* map, const MapLevel* level);
+void unloadMapPicker(MapPicker* picker);
+
+// Returns the polygon containing the lon/lat point at the current zoom's
+// level of detail, or -1 over the ocean
+int pickPolygon(WorldMap* map, float lon, float lat);
+
+// Returns the country under a screen position, or -1
+int pickCountryAt(WorldMap* map, Vector2 screenPos);
+
+#endif
@@ -0,0 +1,41 @@
+// platform.h
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdbool.h>
+
+// Build variant printed next to load and frame timings, so the threaded and
+// single-threaded web builds can be compared
+#if defined(PLATFORM_WEB) && defined(__EMSCRIPTEN_PTHREADS__)
+#define PLATFORM_VARIANT "web-mt"
+#elif defined(PLATFORM_WEB)
+#define PLATFORM_VARIANT "web"
+#else
+#define PLATFORM_VARIANT "native"
+#endif
+
+// Statuses live in IndexedDB on the web (IDBFS mounted at PERSIST_DIR) so
+// they survive reloads; natively they sit in the working directory.
+#ifdef PLATFORM_WEB
+#define PERSIST_DIR "/persist"
+#define STATUS_FILE_PATH PERSIST_DIR "/country_statuses.dat"
+#else
+#define STATUS_FILE_PATH "country_statuses.dat"
+#endif
+
+// Mounts and loads persistent storage before anything reads from it;
+// blocks until IndexedDB has been read. No-op natively.
+void mountPersistentStorage(void);
+
+// Writes persistent storage back after a change; asynchronous on the web
+void syncPersistentStorage(void);
+
+// Call first thing in main. Natively the startup clock starts here; on the
+// web it starts at navigation, so it includes downloading the bundle.
+void markStartup(void);
+double getStartupMilliseconds(void);
+
+// Bytes fetched over the network so far, or -1 where that is unknown
+double getTransferredBytes(void);
+
+#endif
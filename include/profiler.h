@@ -0,0 +1,66 @@
+// profiler.h
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+
+// Build with -DTT_PROFILE=0 (make PROFILE=0) to compile every probe out
+#ifndef TT_PROFILE
+#define TT_PROFILE 1
+#endif
+
+#define PROFILE_RING_SIZE 65536         // Events kept, must be a power of two
+#define PROFILE_OVERLAY_FRAMES 240      // Frames summarised by the overlay
+#define PROFILE_TRACE_FRAMES 600        // Frames written by exportProfileTrace
+
+typedef enum {
+    PROF_FRAME = 0,     // Whole frame, recorded by profileFrameEnd
+    PROF_INPUT,
+    PROF_PICKING,
+    PROF_BACKGROUND,
+    PROF_MAP_LAYER,
+    PROF_CULLING,
+    PROF_FILL,
+    PROF_OUTLINE,
+    PROF_UI,
+    PROF_TILE_RENDER,   // Tile workers, off the frame's critical path
+    PROF_STAGE_COUNT
+} ProfileStage;
+
+#if TT_PROFILE
+
+// Scoped timers: PROF_BEGIN(PROF_FILL); ... PROF_END(PROF_FILL);
+#define PROF_BEGIN(stage) double profStart_##stage = profileNow()
+#define PROF_END(stage) profileRecord(stage, profStart_##stage, profileNow())
+
+double profileNow(void);
+
+// Stores one timed event in the ring; safe from any thread
+void profileRecord(ProfileStage stage, double start, double end);
+
+// Closes the current frame; call once per frame after EndDrawing
+void profileFrameEnd(void);
+
+// Frame-time graph and per-stage p50/p95/p99 over the last frames
+void drawProfileOverlay(int x, int y);
+
+// Writes the last frames as Chrome trace_event JSON (chrome://tracing)
+bool exportProfileTrace(const char* filename, int frames);
+
+// Prints per-stage p50/p95/p99 over the last PROFILE_TRACE_FRAMES frames to
+// stdout (the browser console on the web), headed by label
+void printProfileSummary(const char* label);
+
+#else
+
+#define PROF_BEGIN(stage) ((void)0)
+#define PROF_END(stage) ((void)0)
+
+static inline void profileFrameEnd(void) {}
+static inline void drawProfileOverlay(int x, int y) { (void)x; (void)y; }
+static inline bool exportProfileTrace(const char* filename, int frames) { (void)filename; (void)frames; return false; }
+static inline void printProfileSummary(const char* label) { (void)label; }
+
+#endif
+
+#endif
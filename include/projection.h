@@ -0,0 +1,38 @@
+// projection.h
+#ifndef PROJECTION_H
+#define PROJECTION_H
+
+#include "raylib.h"
+#include <stdbool.h>
+
+// The map projection is affine per axis: screen = lonLat * scale + translate.
+// The inverse is affine too, so one kernel converts in both directions.
+typedef struct {
+    Vector2 scale;
+    Vector2 translate;
+} MapCamera;
+
+typedef enum {
+    PROJECTION_KERNEL_AUTO = 0,     // Best kernel the CPU supports
+    PROJECTION_KERNEL_SCALAR,
+    PROJECTION_KERNEL_SSE2,
+    PROJECTION_KERNEL_AVX2,
+    PROJECTION_KERNEL_SIMD128,      // WebAssembly, needs -msimd128
+    PROJECTION_KERNEL_COUNT
+} ProjectionKernel;
+
+// Lon/lat to screen for the given zoom and offset, matching longitudeToScreenX
+// and latitudeToScreenY
+MapCamera getMapCamera(float zoom, Vector2 offset);
+MapCamera invertMapCamera(MapCamera camera);
+
+// Transforms count points; in and out may be the same array
+void projectPoints(MapCamera camera, const Vector2* in, Vector2* out, int count);
+
+// Kernel selection, for benchmarks and debugging. Returns false when the
+// kernel is not compiled in or not supported by this CPU.
+bool setProjectionKernel(ProjectionKernel kernel);
+ProjectionKernel getProjectionKernel(void);
+const char* getProjectionKernelName(ProjectionKernel kernel);
+
+#endif
@@ -0,0 +1,37 @@
+// raster.h
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "map_utils.h"
+#include "thread_pool.h"
+
+// CPU renderer for share images, independent of any window or GPU. The
+// image is cut into tiles that are rasterized in parallel; each tile fills
+// its polygons with a sorted active-edge scanline and anti-aliased coverage,
+// then strokes the borders on top.
+#define RASTER_TILE_SIZE 64
+#define RASTER_SUBSAMPLES 4     // Sub-scanlines per pixel row
+
+typedef struct {
+    int width;
+    int height;
+    Vector2 center;     // Lon/lat at the middle of the image
+    float zoom;         // 1 fits the whole world across the width, as in the window
+    bool transparent;   // Leave the sea clear instead of SPACE_BG_COLOR, for compositing
+} RasterView;
+
+// Projected points, tile bins and per-worker scratch for one map. Reusable
+// across renders; the map itself is only read, so contexts on different
+// threads may share it.
+typedef struct RasterContext RasterContext;
+
+RasterContext* createRasterContext(const WorldMap* map, int workers);
+void destroyRasterContext(RasterContext* context);
+
+// Renders into a new RGBA8 image (release with UnloadImage) in the window's
+// status colors. The pool may be NULL; otherwise it must not have more
+// threads than the context has workers.
+bool renderMapImage(RasterContext* context, const CountryStatusList* statuses, RasterView view,
+                    ThreadPool* pool, Image* image);
+
+#endif
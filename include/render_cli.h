@@ -0,0 +1,18 @@
+// render_cli.h
+#ifndef RENDER_CLI_H
+#define RENDER_CLI_H
+
+#include <stdbool.h>
+
+// Headless share-image rendering, run instead of the window when the command
+// line asks for it:
+//   traveltint --render out.png [--status file.dat] [--center lon,lat]
+//              [--zoom z] [--size WxH] [--map world.geojson]
+//   traveltint --batch manifest.txt [--center lon,lat] [--zoom z]
+//              [--size WxH] [--map world.geojson]
+// A batch loads the map once and renders every "status.dat out.png" line of
+// the manifest across all cores, reporting images per second at the end.
+bool isRenderCommand(int argc, char** argv);
+int runRenderCommand(int argc, char** argv);
+
+#endif
@@ -0,0 +1,31 @@
+// spatial_index.h
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "map_utils.h"
+
+#define SPATIAL_GRID_CELL_DEGREES 2.0f
+
+// Uniform lon/lat grid over the polygon bounds, built once at load. Each cell
+// lists the polygons whose bounds overlap it (stored CSR style in one array).
+struct SpatialGrid {
+    float cellSize;
+    int cols;
+    int rows;
+    int* cellStart;         // cols * rows + 1 offsets into cellItems
+    int* cellItems;
+    const PolygonBounds* bounds;
+    int itemCount;
+    unsigned int* visitStamp;  // Per polygon, used to report each one once
+    unsigned int stamp;
+};
+
+SpatialGrid* buildSpatialGrid(const PolygonBounds* bounds, int count);
+void unloadSpatialGrid(SpatialGrid* grid);
+
+// Writes the indices of polygons whose bounds overlap `area` (lon/lat, with
+// x/y as the minimum corner) into `results`, which must hold every polygon.
+// Returns how many were written.
+int querySpatialGrid(SpatialGrid* grid, Rectangle area, int* results);
+
+#endif
@@ -0,0 +1,54 @@
+// status_store.h
+#ifndef STATUS_STORE_H
+#define STATUS_STORE_H
+
+#include "map_utils.h"
+#include <stdint.h>
+
+// Statuses live in a snapshot file plus an append-only journal next to it
+// (<file>.journal) holding the changes made since the snapshot was written.
+// Both are little-endian and checksummed; a snapshot is replaced by writing
+// <file>.tmp and renaming it over the old one.
+#define STATUS_FILE_MAGIC "TTST"
+#define STATUS_FILE_VERSION 1
+#define STATUS_JOURNAL_MAGIC "TTSJ"
+#define STATUS_JOURNAL_VERSION 1
+#define STATUS_JOURNAL_EXTENSION ".journal"
+
+// Journal length at which the writer folds it into a fresh snapshot
+#define STATUS_JOURNAL_COMPACT_RECORDS 256
+
+// Snapshot: header followed by `count` 4-byte entries (iso[2], status, 0).
+// Journal: magic and version, then 8-byte records (iso[2], status, 0,
+// FNV-1a of those 4 bytes); replay stops at the first damaged record.
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t checksum;      // FNV-1a of the entries
+} StatusFileHeader;
+
+// Replays snapshot and journal. Files in the old unversioned format (a raw
+// count followed by CountryStatus structs) are still read.
+CountryStatusList* LoadCountryStatuses(const char* filename);
+
+// Writes a snapshot synchronously and drops the journal it supersedes
+void SaveCountryStatuses(const char* filename, CountryStatusList* list);
+
+// Background writer: appendStatusJournal only queues the change, a writer
+// thread appends it and compacts once the journal grows too long. Without
+// threads the record is appended inline, which is still a few bytes.
+typedef struct StatusJournal StatusJournal;
+
+StatusJournal* openStatusJournal(const char* filename, const CountryStatusList* list);
+void appendStatusJournal(StatusJournal* journal, const char* iso_code, int status);
+
+// True once after queued changes have been written and synced to the file,
+// including any compaction they caused. Poll it from the main thread to
+// persist the file further (see syncPersistentStorage).
+bool takeStatusJournalFlush(StatusJournal* journal);
+
+// Flushes pending changes, compacts and stops the writer
+void closeStatusJournal(StatusJournal* journal);
+
+#endif
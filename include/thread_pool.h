@@ -0,0 +1,34 @@
+// thread_pool.h
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+
+// Threads are available natively and in pthread-enabled Emscripten builds;
+// everywhere else a pool runs its jobs inline on the calling thread.
+#if !defined(PLATFORM_WEB) || defined(__EMSCRIPTEN_PTHREADS__)
+#define TT_THREADS 1
+#endif
+
+// Overrides the worker count picked from the number of cores
+#define THREAD_POOL_ENV "TRAVELTINT_THREADS"
+
+// Runs job item `index` on thread `worker` (0 is the calling thread), so
+// tasks can keep per-worker scratch in an array sized by getThreadPoolSize.
+typedef void (*ParallelTask)(void* context, int index, int worker);
+
+typedef struct ThreadPool ThreadPool;
+
+// threadCount <= 0 uses THREAD_POOL_ENV or the core count
+ThreadPool* createThreadPool(int threadCount);
+void destroyThreadPool(ThreadPool* pool);
+
+// Threads taking part in a job, including the caller; 1 for a NULL pool
+int getThreadPoolSize(const ThreadPool* pool);
+
+// Runs task for every index in [0, count) and returns once all are done.
+// Items are handed out in order but may finish in any order; a NULL pool
+// runs them inline.
+void parallelFor(ThreadPool* pool, int count, ParallelTask task, void* context);
+
+#endif
@@ -0,0 +1,16 @@
+// triangulate.h
+#ifndef TRIANGULATE_H
+#define TRIANGULATE_H
+
+#include "raylib.h"
+
+// Triangulates a simple polygon ring by ear clipping. A closing point equal to
+// the first one is ignored. Writes 3 indices per triangle into `indices`, which
+// must hold at least 3 * (numPoints - 2) ints, and returns the triangle count.
+// `scratch` is work space for 2 * numPoints ints, so repeated calls during a
+// load don't allocate.
+// Triangles are emitted counter-clockwise in lon/lat space, which is the
+// winding raylib expects once latitude is flipped to screen Y.
+int triangulatePolygon(const Vector2* points, int numPoints, int* indices, int* scratch);
+
+#endif
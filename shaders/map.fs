@@ -0,0 +1,11 @@
+#version 330
+
+in vec2 fragTexCoord;
+
+uniform sampler2D texture0;
+
+out vec4 finalColor;
+
+void main() {
+    finalColor = texture(texture0, fragTexCoord);
+}
@@ -0,0 +1,25 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;     // x = longitude, y = latitude
+in vec2 vertexTexCoord;     // Country texel in the color lookup
+
+// Output vertex attributes (to fragment shader)
+out vec2 fragTexCoord;
+
+// Uniform inputs
+uniform mat4 mvp;
+uniform float zoom;
+uniform vec2 offset;
+uniform vec2 screenSize;
+
+void main() {
+    // Same projection as longitudeToScreenX / latitudeToScreenY
+    vec2 screen = vec2(
+        (vertexPosition.x + 180.0) * (screenSize.x / 360.0),
+        (90.0 - vertexPosition.y) * (screenSize.y / 180.0)
+    ) * zoom + offset;
+
+    fragTexCoord = vertexTexCoord;
+    gl_Position = mvp*vec4(screen, 0.0, 1.0);
+}
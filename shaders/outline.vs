@@ -0,0 +1,31 @@
+#version 330
+
+// Input vertex attributes
+in vec3 vertexPosition;     // This end of the edge, x = longitude, y = latitude
+in vec3 vertexNormal;       // xy = the other end, z = side of the edge (+1 or -1)
+
+// Uniform inputs
+uniform mat4 mvp;
+uniform float zoom;
+uniform vec2 offset;
+uniform vec2 screenSize;
+uniform float halfWidth;    // Pixels
+
+// Same projection as longitudeToScreenX / latitudeToScreenY
+vec2 project(vec2 lonLat) {
+    return vec2(
+        (lonLat.x + 180.0) * (screenSize.x / 360.0),
+        (90.0 - lonLat.y) * (screenSize.y / 180.0)
+    ) * zoom + offset;
+}
+
+void main() {
+    vec2 here = project(vertexPosition.xy);
+    vec2 direction = project(vertexNormal.xy) - here;
+    float len = length(direction);
+    direction = len > 0.0 ? direction / len : vec2(1.0, 0.0);
+
+    // Widen in screen space so borders keep their width at every zoom
+    vec2 normal = vec2(-direction.y, direction.x);
+    gl_Position = mvp*vec4(here + normal * vertexNormal.z * halfWidth, 0.0, 1.0);
+}
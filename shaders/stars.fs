@@ -3,6 +3,7 @@
 uniform float time;
 uniform float screenWidth;
 uniform float screenHeight;
+uniform int octaves;        // Detail of each fbm layer, set by the quality tier
 
 out vec4 finalColor;
 
@@ -28,6 +29,7 @@ float fbm(vec2 x) {
     mat2 rot = mat2(cos(0.5), sin(0.5), -sin(0.5), cos(0.5));
     
     for (int i = 0; i < 6; i++) {
+        if (i >= octaves) break;
         v += a * noise(x);
         x = rot * x * 2.0 + vec2(100.0);
         a *= 0.5;
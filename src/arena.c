@@ -0,0 +1,29 @@
+#include "arena.h"
+#include <stdlib.h>
+
+size_t arenaAlignSize(size_t size) {
+    return (size + 15) & ~(size_t)15;
+}
+
+bool arenaInit(MapArena* arena, size_t size) {
+    arena->base = (unsigned char*)malloc(size > 0 ? size : 1);
+    arena->size = arena->base ? size : 0;
+    arena->used = 0;
+    return arena->base != NULL;
+}
+
+void* arenaAlloc(MapArena* arena, size_t size) {
+    size = arenaAlignSize(size);
+    if (!arena->base || arena->used + size > arena->size) return NULL;
+
+    void* ptr = arena->base + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+void arenaFree(MapArena* arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
@@ -0,0 +1,152 @@
+#include "background.h"
+#include "map_utils.h"
+#include "profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static const BackgroundTier tiers[BACKGROUND_QUALITY_COUNT] = {
+    { "Off",    0.0f,  0.0f,  0 },
+    { "Low",    0.25f, 5.0f,  3 },
+    { "Medium", 0.5f,  10.0f, 4 },
+    { "High",   1.0f,  30.0f, 6 },
+};
+
+const BackgroundTier* getBackgroundTier(BackgroundQuality quality) {
+    if ((int)quality < 0 || quality >= BACKGROUND_QUALITY_COUNT) quality = BACKGROUND_QUALITY_OFF;
+    return &tiers[quality];
+}
+
+static void unloadTargets(Background* background) {
+    if (background->width == 0) return;
+    for (int i = 0; i < 2; i++) {
+        UnloadRenderTexture(background->targets[i]);
+    }
+    background->width = background->height = 0;
+    background->primed = false;
+}
+
+// (Re)creates the targets when the tier or the window size asks for another size
+static void fitTargets(Background* background) {
+    const BackgroundTier* tier = getBackgroundTier(background->quality);
+    int width = (int)(GetScreenWidth() * tier->scale);
+    int height = (int)(GetScreenHeight() * tier->scale);
+    if (!background->shaderReady || width <= 0 || height <= 0) {
+        unloadTargets(background);
+        return;
+    }
+    if (width == background->width && height == background->height) return;
+
+    unloadTargets(background);
+    for (int i = 0; i < 2; i++) {
+        background->targets[i] = LoadRenderTexture(width, height);
+        SetTextureFilter(background->targets[i].texture, TEXTURE_FILTER_BILINEAR);
+    }
+    background->width = width;
+    background->height = height;
+}
+
+Background* loadBackground(BackgroundQuality quality) {
+    Background* background = (Background*)calloc(1, sizeof(Background));
+    if (!background) return NULL;
+
+    #ifndef PLATFORM_WEB
+    background->shader = LoadShader("shaders/stars.vs", "shaders/stars.fs");
+    if (background->shader.id == 0) {
+        printf("ERROR: Shader failed to compile!\n");
+    } else {
+        background->timeLoc = GetShaderLocation(background->shader, "time");
+        background->screenWidthLoc = GetShaderLocation(background->shader, "screenWidth");
+        background->screenHeightLoc = GetShaderLocation(background->shader, "screenHeight");
+        background->octavesLoc = GetShaderLocation(background->shader, "octaves");
+
+        background->shaderReady = background->timeLoc != -1 && background->screenWidthLoc != -1 &&
+                                  background->screenHeightLoc != -1 && background->octavesLoc != -1;
+        if (!background->shaderReady) {
+            printf("ERROR: Failed to get shader uniform locations!\n");
+        }
+    }
+    #endif
+
+    setBackgroundQuality(background, quality);
+    return background;
+}
+
+void unloadBackground(Background* background) {
+    if (!background) return;
+    unloadTargets(background);
+    if (background->shader.id != 0) UnloadShader(background->shader);
+    free(background);
+}
+
+void setBackgroundQuality(Background* background, BackgroundQuality quality) {
+    if (!background) return;
+    if ((int)quality < 0 || quality >= BACKGROUND_QUALITY_COUNT) quality = BACKGROUND_QUALITY_OFF;
+    background->quality = quality;
+    background->primed = false;
+    fitTargets(background);
+}
+
+static void renderNebula(Background* background, int target, float time) {
+    PROF_BEGIN(PROF_BACKGROUND);
+    const BackgroundTier* tier = getBackgroundTier(background->quality);
+    float width = (float)background->width;
+    float height = (float)background->height;
+
+    SetShaderValue(background->shader, background->timeLoc, &time, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(background->shader, background->screenWidthLoc, &width, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(background->shader, background->screenHeightLoc, &height, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(background->shader, background->octavesLoc, &tier->octaves, SHADER_UNIFORM_INT);
+
+    BeginTextureMode(background->targets[target]);
+    BeginShaderMode(background->shader);
+    DrawRectangle(0, 0, background->width, background->height, WHITE);
+    EndShaderMode();
+    EndTextureMode();
+    PROF_END(PROF_BACKGROUND);
+}
+
+void updateBackground(Background* background, double time) {
+    if (!background) return;
+    fitTargets(background);
+    if (background->width == 0) return;
+
+    const BackgroundTier* tier = getBackgroundTier(background->quality);
+    double period = 1.0 / tier->updateRate;
+
+    if (!background->primed) {
+        renderNebula(background, 0, (float)time);
+        renderNebula(background, 1, (float)time);
+        background->current = 1;
+        background->lastUpdate = time;
+        background->primed = true;
+        return;
+    }
+
+    if (time - background->lastUpdate < period) return;
+
+    // The older frame becomes the new one; the fade restarts from the other
+    background->current = 1 - background->current;
+    renderNebula(background, background->current, (float)time);
+    background->lastUpdate = time;
+}
+
+static void drawTarget(const Background* background, int target, Color tint) {
+    const Texture2D* texture = &background->targets[target].texture;
+    Rectangle source = { 0, 0, (float)texture->width, -(float)texture->height };
+    Rectangle dest = { 0, 0, (float)GetScreenWidth(), (float)GetScreenHeight() };
+    DrawTexturePro(*texture, source, dest, (Vector2){ 0, 0 }, 0.0f, tint);
+}
+
+void drawBackground(const Background* background, double time) {
+    ClearBackground(SPACE_BG_COLOR);
+    if (!background || background->width == 0 || !background->primed) return;
+
+    const BackgroundTier* tier = getBackgroundTier(background->quality);
+    float fade = (float)((time - background->lastUpdate) * tier->updateRate);
+    if (fade > 1.0f) fade = 1.0f;
+
+    PROF_BEGIN(PROF_BACKGROUND);
+    drawTarget(background, 1 - background->current, WHITE);
+    drawTarget(background, background->current, Fade(WHITE, fade));
+    PROF_END(PROF_BACKGROUND);
+}
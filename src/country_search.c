@@ -0,0 +1,144 @@
+#include "country_search.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_PREFIX_MAX 64
+
+enum {
+    MATCH_START,    // ISO code or the start of the name
+    MATCH_WORD      // A later word of the name
+};
+
+typedef struct {
+    const char* key;    // Lowercase, into CountrySearch.text
+    int country;
+    int kind;
+} SearchEntry;
+
+struct CountrySearch {
+    SearchEntry* entries;
+    int entryCount;
+    char* text;         // Every key back to back, NUL-terminated
+};
+
+static bool isWordStart(const char* name, int i) {
+    return i > 0 && isalnum((unsigned char)name[i]) && !isalnum((unsigned char)name[i - 1]);
+}
+
+static int compareEntries(const void* a, const void* b) {
+    const SearchEntry* x = (const SearchEntry*)a;
+    const SearchEntry* y = (const SearchEntry*)b;
+    int order = strcmp(x->key, y->key);
+    if (order != 0) return order;
+    return x->country - y->country;
+}
+
+static char* addKey(char* out, const char* source, size_t length) {
+    for (size_t i = 0; i < length; i++) out[i] = (char)tolower((unsigned char)source[i]);
+    out[length] = '\0';
+    return out + length + 1;
+}
+
+CountrySearch* buildCountrySearch(const WorldMap* map) {
+    if (!map) return NULL;
+
+    // Sizes first: one key per ISO code, one per word start in the name
+    int entryCount = 0;
+    size_t textSize = 0;
+    for (int c = 0; c < map->countryCount; c++) {
+        const Country* country = &map->countries[c];
+        size_t nameLength = strlen(country->name);
+        if (nameLength > 0) {
+            entryCount++;
+            textSize += nameLength + 1;
+        }
+        for (int i = 1; i < (int)nameLength; i++) {
+            if (!isWordStart(country->name, i)) continue;
+            entryCount++;
+            textSize += nameLength - i + 1;
+        }
+        if (country->iso_code[0] != '\0') {
+            entryCount++;
+            textSize += strlen(country->iso_code) + 1;
+        }
+    }
+
+    CountrySearch* search = (CountrySearch*)calloc(1, sizeof(CountrySearch));
+    if (!search) return NULL;
+    search->entries = (SearchEntry*)malloc(sizeof(SearchEntry) * (entryCount > 0 ? entryCount : 1));
+    search->text = (char*)malloc(textSize > 0 ? textSize : 1);
+    if (!search->entries || !search->text) {
+        unloadCountrySearch(search);
+        return NULL;
+    }
+
+    char* out = search->text;
+    for (int c = 0; c < map->countryCount; c++) {
+        const Country* country = &map->countries[c];
+        const char* name = country->name;
+        size_t nameLength = strlen(name);
+        if (nameLength > 0) {
+            search->entries[search->entryCount++] = (SearchEntry){ out, c, MATCH_START };
+            out = addKey(out, name, nameLength);
+        }
+        for (int i = 1; i < (int)nameLength; i++) {
+            if (!isWordStart(name, i)) continue;
+            search->entries[search->entryCount++] = (SearchEntry){ out, c, MATCH_WORD };
+            out = addKey(out, name + i, nameLength - i);
+        }
+        if (country->iso_code[0] != '\0') {
+            search->entries[search->entryCount++] = (SearchEntry){ out, c, MATCH_START };
+            out = addKey(out, country->iso_code, strlen(country->iso_code));
+        }
+    }
+
+    qsort(search->entries, search->entryCount, sizeof(SearchEntry), compareEntries);
+    return search;
+}
+
+void unloadCountrySearch(CountrySearch* search) {
+    if (!search) return;
+    free(search->entries);
+    free(search->text);
+    free(search);
+}
+
+static bool containsCountry(const int* results, int count, int country) {
+    for (int i = 0; i < count; i++) {
+        if (results[i] == country) return true;
+    }
+    return false;
+}
+
+int searchCountries(const CountrySearch* search, const char* prefix, int* results, int maxResults) {
+    if (!search || !prefix || prefix[0] == '\0' || maxResults <= 0) return 0;
+
+    char key[SEARCH_PREFIX_MAX];
+    size_t length = strlen(prefix);
+    if (length >= sizeof(key)) length = sizeof(key) - 1;
+    addKey(key, prefix, length);
+
+    // First entry not ordered before the prefix
+    int low = 0, high = search->entryCount;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (strncmp(search->entries[mid].key, key, length) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    int end = low;
+    while (end < search->entryCount && strncmp(search->entries[end].key, key, length) == 0) end++;
+
+    int count = 0;
+    for (int kind = MATCH_START; kind <= MATCH_WORD; kind++) {
+        for (int i = low; i < end && count < maxResults; i++) {
+            const SearchEntry* entry = &search->entries[i];
+            if (entry->kind != kind || containsCountry(results, count, entry->country)) continue;
+            results[count++] = entry->country;
+        }
+    }
+    return count;
+}
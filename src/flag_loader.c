@@ -0,0 +1,584 @@
+#include "flag_loader.h"
+#include "thread_pool.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NANOSVG_IMPLEMENTATION
+#include "nanosvg.h"
+#define NANOSVGRAST_IMPLEMENTATION
+#include "nanosvgrast.h"
+
+#ifdef TT_THREADS
+#include <pthread.h>
+#endif
+
+#ifdef PLATFORM_WEB
+#include <emscripten/fetch.h>
+#endif
+
+#define FLAG_CACHE_HEADER_SIZE 16
+#define FLAG_ATLAS_MAX_SHELVES 64
+
+enum {
+    FLAG_NONE,
+    FLAG_PENDING,
+    FLAG_READY,
+    FLAG_MISSING
+};
+
+typedef struct {
+    int countryIndex;
+    char iso_code[3];
+    unsigned char* svg;     // Already fetched text, owned by the job; else read from disk
+    size_t svgSize;
+} FlagJob;
+
+typedef struct {
+    int countryIndex;
+    Image image;        // No data if the flag could not be loaded
+} FlagResult;
+
+typedef struct {
+    int y;
+    int height;
+    int x;              // Start of the free space on the right
+} AtlasShelf;
+
+typedef struct {
+    Texture2D texture;
+    AtlasShelf shelves[FLAG_ATLAS_MAX_SHELVES];
+    int shelfCount;
+    unsigned int lastUsed;  // Frame a flag on it was last drawn
+} AtlasPage;
+
+typedef struct {
+    int page;           // -1 when the flag is not in the atlas
+    Rectangle source;
+} FlagSlot;
+
+typedef struct {
+    FlagLoader* loader;
+    int index;
+    NSVGrasterizer* rasterizer;
+#ifdef TT_THREADS
+    pthread_t thread;
+#endif
+} FlagWorker;
+
+struct FlagLoader {
+    // Main thread only
+    unsigned char* states;      // Per country
+    FlagSlot* slots;            // Per country
+    int countryCount;
+    AtlasPage pages[FLAG_ATLAS_MAX_PAGES];
+    int pageCount;              // Pages created so far
+    int pageLimit;              // Pages the budget allows
+    unsigned int frame;
+    char cacheDir[256];         // Empty for no cache
+
+    // Shared with the workers under lock. A country is pending at most once
+    // at a time, so both queues are sized by the country count: jobs is a
+    // ring indexed by the running head and tail counts.
+    FlagJob* jobs;
+    int jobHead;
+    int jobCount;
+    int jobCapacity;
+    FlagResult* results;
+    int resultCount;
+    FlagWorker workers[FLAG_LOADER_WORKERS];
+    int workerCount;
+#ifdef TT_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stopping;
+#endif
+};
+
+static uint64_t fnv1a64(const unsigned char* data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static void putU32(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t getU32(const unsigned char* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static unsigned char* readFile(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // One spare byte so the SVG text can be terminated for the parser
+    unsigned char* data = length >= 0 ? (unsigned char*)malloc((size_t)length + 1) : NULL;
+    if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    if (!data) return NULL;
+    data[length] = '\0';
+    *size = (size_t)length;
+    return data;
+}
+
+// The key covers the SVG bytes and everything that shapes the pixels
+static void getCachePath(const FlagLoader* loader, const unsigned char* svg, size_t size, char* path, size_t pathSize) {
+    unsigned char params[12];
+    putU32(params, FLAG_CACHE_VERSION);
+    putU32(params + 4, FLAG_MAX_WIDTH);
+    putU32(params + 8, FLAG_MAX_HEIGHT);
+    uint64_t hash = fnv1a64(params, sizeof(params), 14695981039346656037ull);
+    hash = fnv1a64(svg, size, hash);
+    snprintf(path, pathSize, "%s/%016llx.flag", loader->cacheDir, (unsigned long long)hash);
+}
+
+static bool readCachedFlag(const char* path, Image* image) {
+    size_t size = 0;
+    unsigned char* data = readFile(path, &size);
+    if (!data) return false;
+
+    bool ok = size >= FLAG_CACHE_HEADER_SIZE && memcmp(data, FLAG_CACHE_MAGIC, 4) == 0 &&
+              getU32(data + 4) == FLAG_CACHE_VERSION;
+    int width = ok ? (int)getU32(data + 8) : 0;
+    int height = ok ? (int)getU32(data + 12) : 0;
+    ok = ok && width > 0 && width <= FLAG_MAX_WIDTH && height > 0 && height <= FLAG_MAX_HEIGHT &&
+         size == FLAG_CACHE_HEADER_SIZE + (size_t)width * height * 4;
+    if (ok) {
+        // Pixels moved to the front so the block can be the image's own
+        memmove(data, data + FLAG_CACHE_HEADER_SIZE, (size_t)width * height * 4);
+        *image = (Image){ data, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    } else {
+        free(data);
+    }
+    return ok;
+}
+
+// Written beside the final name and renamed, so readers never see half a file
+static void writeCachedFlag(const char* path, int worker, Image image) {
+    char tempPath[320];
+    snprintf(tempPath, sizeof(tempPath), "%s.%d.tmp", path, worker);
+    FILE* file = fopen(tempPath, "wb");
+    if (!file) return;
+
+    unsigned char header[FLAG_CACHE_HEADER_SIZE];
+    memcpy(header, FLAG_CACHE_MAGIC, 4);
+    putU32(header + 4, FLAG_CACHE_VERSION);
+    putU32(header + 8, (uint32_t)image.width);
+    putU32(header + 12, (uint32_t)image.height);
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(image.data, (size_t)image.width * image.height * 4, 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tempPath, path) != 0) remove(tempPath);
+}
+
+static bool rasterizeFlag(NSVGrasterizer* rasterizer, char* svg, Image* image) {
+    NSVGimage* parsed = nsvgParse(svg, "px", 96.0f);
+    if (!parsed) return false;
+
+    bool ok = false;
+    if (parsed->width > 0.0f && parsed->height > 0.0f) {
+        float scale = fminf(FLAG_MAX_WIDTH / parsed->width, FLAG_MAX_HEIGHT / parsed->height);
+        int width = (int)fmaxf(1.0f, roundf(parsed->width * scale));
+        int height = (int)fmaxf(1.0f, roundf(parsed->height * scale));
+        unsigned char* pixels = (unsigned char*)malloc((size_t)width * height * 4);
+        if (pixels) {
+            nsvgRasterize(rasterizer, parsed, 0.0f, 0.0f, scale, pixels, width, height, width * 4);
+            *image = (Image){ pixels, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+            ok = true;
+        }
+    }
+    nsvgDelete(parsed);
+    return ok;
+}
+
+static Image loadFlagImage(FlagWorker* worker, const FlagJob* job) {
+    const FlagLoader* loader = worker->loader;
+    char path[512];
+    snprintf(path, sizeof(path), "assets/flags/%s.svg", job->iso_code);
+
+    Image image = { 0 };
+    size_t size = job->svgSize;
+    unsigned char* svg = job->svg ? job->svg : readFile(path, &size);
+    if (!svg) return image;
+
+    char cachePath[320];
+    if (loader->cacheDir[0] != '\0') {
+        getCachePath(loader, svg, size, cachePath, sizeof(cachePath));
+        if (readCachedFlag(cachePath, &image)) {
+            free(svg);
+            return image;
+        }
+    }
+
+    // The parser works in place on the text
+    if (rasterizeFlag(worker->rasterizer, (char*)svg, &image) && loader->cacheDir[0] != '\0') {
+        writeCachedFlag(cachePath, worker->index, image);
+    }
+    free(svg);
+    return image;
+}
+
+static void lockLoader(FlagLoader* loader) {
+#ifdef TT_THREADS
+    pthread_mutex_lock(&loader->lock);
+#else
+    (void)loader;
+#endif
+}
+
+static void unlockLoader(FlagLoader* loader) {
+#ifdef TT_THREADS
+    pthread_mutex_unlock(&loader->lock);
+#else
+    (void)loader;
+#endif
+}
+
+static void runJob(FlagWorker* worker, FlagJob job) {
+    Image image = loadFlagImage(worker, &job);
+    FlagLoader* loader = worker->loader;
+    lockLoader(loader);
+    loader->results[loader->resultCount++] = (FlagResult){ job.countryIndex, image };
+    unlockLoader(loader);
+}
+
+#ifdef TT_THREADS
+static void* workerMain(void* arg) {
+    FlagWorker* worker = (FlagWorker*)arg;
+    FlagLoader* loader = worker->loader;
+
+    pthread_mutex_lock(&loader->lock);
+    for (;;) {
+        while (!loader->stopping && loader->jobHead == loader->jobCount) {
+            pthread_cond_wait(&loader->wake, &loader->lock);
+        }
+        if (loader->stopping) break;
+        FlagJob job = loader->jobs[loader->jobHead++ % loader->jobCapacity];
+        pthread_mutex_unlock(&loader->lock);
+
+        runJob(worker, job);
+
+        pthread_mutex_lock(&loader->lock);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+#endif
+
+FlagLoader* loadFlagLoader(const WorldMap* map, const char* cacheDir, long budgetBytes) {
+    if (!map) return NULL;
+    FlagLoader* loader = (FlagLoader*)calloc(1, sizeof(FlagLoader));
+    if (!loader) return NULL;
+
+    int countryCount = map->countryCount > 0 ? map->countryCount : 1;
+    loader->countryCount = map->countryCount;
+    loader->jobCapacity = countryCount;
+    loader->states = (unsigned char*)calloc(countryCount, 1);
+    loader->slots = (FlagSlot*)malloc(sizeof(FlagSlot) * countryCount);
+    loader->jobs = (FlagJob*)malloc(sizeof(FlagJob) * countryCount);
+    loader->results = (FlagResult*)malloc(sizeof(FlagResult) * countryCount);
+    long pageBytes = (long)FLAG_ATLAS_SIZE * FLAG_ATLAS_SIZE * 4;
+    long pages = (budgetBytes > 0 ? budgetBytes : FLAG_ATLAS_DEFAULT_BUDGET) / pageBytes;
+    loader->pageLimit = pages < 1 ? 1 : pages > FLAG_ATLAS_MAX_PAGES ? FLAG_ATLAS_MAX_PAGES : (int)pages;
+    if (cacheDir && (mkdir(cacheDir, 0755) == 0 || access(cacheDir, W_OK) == 0)) {
+        snprintf(loader->cacheDir, sizeof(loader->cacheDir), "%s", cacheDir);
+    }
+
+#ifdef TT_THREADS
+    int workerCount = FLAG_LOADER_WORKERS;
+#else
+    int workerCount = 1;    // Runs inline from updateFlagLoader
+#endif
+    bool ok = loader->states && loader->slots && loader->jobs && loader->results;
+    for (int i = 0; ok && i < countryCount; i++) loader->slots[i].page = -1;
+    for (int i = 0; ok && i < workerCount; i++) {
+        loader->workers[i].loader = loader;
+        loader->workers[i].index = i;
+        loader->workers[i].rasterizer = nsvgCreateRasterizer();
+        ok = loader->workers[i].rasterizer != NULL;
+    }
+    if (!ok) {
+        for (int i = 0; i < workerCount; i++) {
+            if (loader->workers[i].rasterizer) nsvgDeleteRasterizer(loader->workers[i].rasterizer);
+        }
+        free(loader->results);
+        free(loader->jobs);
+        free(loader->slots);
+        free(loader->states);
+        free(loader);
+        return NULL;
+    }
+
+#ifdef TT_THREADS
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->wake, NULL);
+    for (int i = 0; i < workerCount; i++) {
+        if (pthread_create(&loader->workers[i].thread, NULL, workerMain, &loader->workers[i]) != 0) break;
+        loader->workerCount++;
+    }
+#else
+    loader->workerCount = workerCount;
+#endif
+    return loader;
+}
+
+void unloadFlagLoader(FlagLoader* loader) {
+    if (!loader) return;
+
+#ifdef TT_THREADS
+    pthread_mutex_lock(&loader->lock);
+    loader->stopping = true;
+    pthread_cond_broadcast(&loader->wake);
+    pthread_mutex_unlock(&loader->lock);
+    for (int i = 0; i < loader->workerCount; i++) pthread_join(loader->workers[i].thread, NULL);
+    pthread_cond_destroy(&loader->wake);
+    pthread_mutex_destroy(&loader->lock);
+#endif
+
+    for (int i = 0; i < FLAG_LOADER_WORKERS; i++) {
+        if (loader->workers[i].rasterizer) nsvgDeleteRasterizer(loader->workers[i].rasterizer);
+    }
+    for (int i = 0; i < loader->resultCount; i++) {
+        if (loader->results[i].image.data) UnloadImage(loader->results[i].image);
+    }
+    for (int i = loader->jobHead; i < loader->jobCount; i++) free(loader->jobs[i % loader->jobCapacity].svg);
+    for (int i = 0; i < loader->pageCount; i++) UnloadTexture(loader->pages[i].texture);
+    free(loader->results);
+    free(loader->jobs);
+    free(loader->slots);
+    free(loader->states);
+    free(loader);
+}
+
+static void queueJob(FlagLoader* loader, int countryIndex, const char* iso_code, unsigned char* svg, size_t svgSize) {
+    lockLoader(loader);
+    FlagJob* job = &loader->jobs[loader->jobCount++ % loader->jobCapacity];
+    job->countryIndex = countryIndex;
+    job->iso_code[0] = iso_code[0];
+    job->iso_code[1] = iso_code[0] ? iso_code[1] : '\0';
+    job->iso_code[2] = '\0';
+    job->svg = svg;
+    job->svgSize = svgSize;
+#ifdef TT_THREADS
+    pthread_cond_signal(&loader->wake);
+#endif
+    unlockLoader(loader);
+}
+
+#ifdef PLATFORM_WEB
+// Flags are not in the web bundle. They are fetched when first shown and
+// kept in IndexedDB by emscripten_fetch, so later visits skip the network.
+// Callbacks run on the main thread; the loader must outlive its fetches.
+typedef struct {
+    FlagLoader* loader;
+    int countryIndex;
+    char iso_code[3];
+} FlagFetch;
+
+// Text goes to the workers to rasterize; a failed download becomes a missing flag
+static void finishFetch(emscripten_fetch_t* fetch, bool ok) {
+    FlagFetch* request = (FlagFetch*)fetch->userData;
+    FlagLoader* loader = request->loader;
+    unsigned char* svg = ok ? (unsigned char*)malloc(fetch->numBytes + 1) : NULL;
+    if (svg) {
+        memcpy(svg, fetch->data, fetch->numBytes);
+        svg[fetch->numBytes] = '\0';
+        queueJob(loader, request->countryIndex, request->iso_code, svg, fetch->numBytes);
+    } else {
+        lockLoader(loader);
+        loader->results[loader->resultCount++] = (FlagResult){ request->countryIndex, { 0 } };
+        unlockLoader(loader);
+    }
+    emscripten_fetch_close(fetch);
+    free(request);
+}
+
+static void flagFetched(emscripten_fetch_t* fetch) {
+    finishFetch(fetch, true);
+}
+
+static void flagFetchFailed(emscripten_fetch_t* fetch) {
+    finishFetch(fetch, false);
+}
+
+static bool fetchFlag(FlagLoader* loader, int countryIndex, const char* iso_code) {
+    FlagFetch* request = (FlagFetch*)malloc(sizeof(FlagFetch));
+    if (!request) return false;
+    *request = (FlagFetch){ loader, countryIndex, { iso_code[0], iso_code[0] ? iso_code[1] : '\0', '\0' } };
+
+    char url[64];
+    snprintf(url, sizeof(url), "assets/flags/%s.svg", request->iso_code);
+    emscripten_fetch_attr_t attr;
+    emscripten_fetch_attr_init(&attr);
+    strcpy(attr.requestMethod, "GET");
+    attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY | EMSCRIPTEN_FETCH_PERSIST_FILE;
+    attr.userData = request;
+    attr.onsuccess = flagFetched;
+    attr.onerror = flagFetchFailed;
+    emscripten_fetch(&attr, url);
+    return true;
+}
+#endif
+
+void requestCountryFlag(FlagLoader* loader, const WorldMap* map, int countryIndex) {
+    if (!loader || countryIndex < 0 || countryIndex >= loader->countryCount) return;
+    if (loader->states[countryIndex] != FLAG_NONE) return;
+
+    const char* iso_code = map->countries[countryIndex].iso_code;
+#ifdef PLATFORM_WEB
+    if (!fetchFlag(loader, countryIndex, iso_code)) return;
+#else
+    queueJob(loader, countryIndex, iso_code, NULL, 0);
+#endif
+    loader->states[countryIndex] = FLAG_PENDING;
+}
+
+// Shelf packing: the lowest shelf the flag fits without wasting more than a
+// quarter of its height, else a new shelf, else any shelf it fits at all
+static bool packOnPage(AtlasPage* page, int width, int height, int* x, int* y) {
+    AtlasShelf* best = NULL;
+    for (int i = 0; i < page->shelfCount; i++) {
+        AtlasShelf* shelf = &page->shelves[i];
+        if (shelf->height < height || shelf->x + width > FLAG_ATLAS_SIZE) continue;
+        if (!best || shelf->height < best->height) best = shelf;
+    }
+
+    if (!best || best->height - height > height / 4) {
+        AtlasShelf* last = page->shelfCount > 0 ? &page->shelves[page->shelfCount - 1] : NULL;
+        int top = last ? last->y + last->height : 0;
+        if (top + height <= FLAG_ATLAS_SIZE && page->shelfCount < FLAG_ATLAS_MAX_SHELVES) {
+            best = &page->shelves[page->shelfCount++];
+            *best = (AtlasShelf){ top, height, 0 };
+        }
+    }
+    if (!best) return false;
+
+    *x = best->x;
+    *y = best->y;
+    best->x += width;
+    return true;
+}
+
+// Empties a page for repacking; its flags go back to unloaded
+static void clearPage(FlagLoader* loader, int pageIndex) {
+    AtlasPage* page = &loader->pages[pageIndex];
+    void* blank = calloc((size_t)FLAG_ATLAS_SIZE * FLAG_ATLAS_SIZE, 4);
+    if (blank) {
+        UpdateTexture(page->texture, blank);
+        free(blank);
+    }
+    page->shelfCount = 0;
+
+    for (int i = 0; i < loader->countryCount; i++) {
+        if (loader->slots[i].page != pageIndex) continue;
+        loader->slots[i].page = -1;
+        loader->states[i] = FLAG_NONE;
+    }
+}
+
+static bool addAtlasPage(FlagLoader* loader) {
+    Image blank = GenImageColor(FLAG_ATLAS_SIZE, FLAG_ATLAS_SIZE, BLANK);
+    Texture2D texture = LoadTextureFromImage(blank);
+    UnloadImage(blank);
+    if (texture.id == 0) return false;
+
+    SetTextureFilter(texture, TEXTURE_FILTER_BILINEAR);
+    loader->pages[loader->pageCount++] = (AtlasPage){ .texture = texture, .lastUsed = loader->frame };
+    return true;
+}
+
+// Finds room for a padded flag: an existing page, a new page while the
+// budget allows, or else the least recently drawn page, cleared
+static int placeFlag(FlagLoader* loader, int width, int height, int* x, int* y) {
+    for (int i = 0; i < loader->pageCount; i++) {
+        if (packOnPage(&loader->pages[i], width, height, x, y)) return i;
+    }
+    if (loader->pageCount < loader->pageLimit && addAtlasPage(loader)) {
+        int page = loader->pageCount - 1;
+        return packOnPage(&loader->pages[page], width, height, x, y) ? page : -1;
+    }
+    if (loader->pageCount == 0) return -1;
+
+    int oldest = 0;
+    for (int i = 1; i < loader->pageCount; i++) {
+        if (loader->pages[i].lastUsed < loader->pages[oldest].lastUsed) oldest = i;
+    }
+    clearPage(loader, oldest);
+    return packOnPage(&loader->pages[oldest], width, height, x, y) ? oldest : -1;
+}
+
+static bool storeFlag(FlagLoader* loader, int country, Image image) {
+    int x, y;
+    int page = placeFlag(loader, image.width + 2 * FLAG_ATLAS_PADDING, image.height + 2 * FLAG_ATLAS_PADDING, &x, &y);
+    if (page < 0) return false;
+
+    // The padding stays clear, so filtering never picks up a neighbour
+    Rectangle source = { (float)(x + FLAG_ATLAS_PADDING), (float)(y + FLAG_ATLAS_PADDING),
+                         (float)image.width, (float)image.height };
+    UpdateTextureRec(loader->pages[page].texture, source, image.data);
+    loader->pages[page].lastUsed = loader->frame;
+    loader->slots[country] = (FlagSlot){ page, source };
+    return true;
+}
+
+void updateFlagLoader(FlagLoader* loader, const WorldMap* map) {
+    if (!loader) return;
+    loader->frame++;
+
+#ifndef TT_THREADS
+    // One flag per frame when there are no workers
+    if (loader->jobHead < loader->jobCount) {
+        FlagJob job = loader->jobs[loader->jobHead++ % loader->jobCapacity];
+        runJob(&loader->workers[0], job);
+    }
+#endif
+
+    FlagResult uploads[FLAG_UPLOADS_PER_FRAME];
+    lockLoader(loader);
+    int uploadCount = loader->resultCount < FLAG_UPLOADS_PER_FRAME ? loader->resultCount : FLAG_UPLOADS_PER_FRAME;
+    memcpy(uploads, loader->results, sizeof(FlagResult) * uploadCount);
+    loader->resultCount -= uploadCount;
+    memmove(loader->results, loader->results + uploadCount, sizeof(FlagResult) * loader->resultCount);
+    unlockLoader(loader);
+
+    for (int i = 0; i < uploadCount; i++) {
+        int country = uploads[i].countryIndex;
+        bool loaded = uploads[i].image.data && storeFlag(loader, country, uploads[i].image);
+        if (uploads[i].image.data) UnloadImage(uploads[i].image);
+
+        loader->states[country] = loaded ? FLAG_READY : FLAG_MISSING;
+        if (!loaded) {
+            printf("Warning: Could not load flag for %s (%s)\n",
+                   map->countries[country].name, map->countries[country].iso_code);
+        }
+    }
+}
+
+bool getCountryFlag(FlagLoader* loader, int countryIndex, Texture2D* texture, Rectangle* source) {
+    if (!loader || countryIndex < 0 || countryIndex >= loader->countryCount) return false;
+    const FlagSlot* slot = &loader->slots[countryIndex];
+    if (loader->states[countryIndex] != FLAG_READY || slot->page < 0) return false;
+
+    AtlasPage* page = &loader->pages[slot->page];
+    page->lastUsed = loader->frame;
+    *texture = page->texture;
+    *source = slot->source;
+    return true;
+}
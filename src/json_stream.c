@@ -0,0 +1,264 @@
+#include "json_stream.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool refill(JsonStream* s) {
+    if (!s->file || s->failed) return false;
+    s->consumed += s->length;
+    s->length = fread(s->buffer, 1, JSON_STREAM_BUFFER_SIZE, s->file);
+    s->pos = 0;
+    s->data = s->buffer;
+    return s->length > 0;
+}
+
+static inline int peekRaw(JsonStream* s) {
+    if (s->pos >= s->length && !refill(s)) return -1;
+    return (unsigned char)s->data[s->pos];
+}
+
+static inline int nextRaw(JsonStream* s) {
+    if (s->pos >= s->length && !refill(s)) return -1;
+    return (unsigned char)s->data[s->pos++];
+}
+
+static bool fail(JsonStream* s) {
+    s->failed = true;
+    return false;
+}
+
+bool jsonStreamOpenFile(JsonStream* s, const char* filename) {
+    memset(s, 0, sizeof(*s));
+    s->file = fopen(filename, "rb");
+    if (!s->file) return false;
+
+    s->buffer = (char*)malloc(JSON_STREAM_BUFFER_SIZE);
+    if (!s->buffer) {
+        fclose(s->file);
+        s->file = NULL;
+        return false;
+    }
+    s->data = s->buffer;
+    return true;
+}
+
+void jsonStreamOpenMemory(JsonStream* s, const char* data, size_t length) {
+    memset(s, 0, sizeof(*s));
+    s->data = data;
+    s->length = length;
+}
+
+void jsonStreamClose(JsonStream* s) {
+    if (s->file) fclose(s->file);
+    free(s->buffer);
+    memset(s, 0, sizeof(*s));
+}
+
+int jsonPeek(JsonStream* s) {
+    if (s->failed) return -1;
+    for (;;) {
+        int c = peekRaw(s);
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return c;
+        s->pos++;
+    }
+}
+
+bool jsonExpect(JsonStream* s, char c) {
+    if (jsonPeek(s) != (unsigned char)c) return fail(s);
+    s->pos++;
+    return true;
+}
+
+bool jsonNextKey(JsonStream* s, bool* first, char* key, size_t keySize) {
+    int c = jsonPeek(s);
+    if (c == '}') {
+        s->pos++;
+        return false;
+    }
+    if (!*first && !jsonExpect(s, ',')) return false;
+    *first = false;
+
+    if (!jsonReadString(s, key, keySize)) return false;
+    return jsonExpect(s, ':');
+}
+
+bool jsonNextElement(JsonStream* s, bool* first) {
+    int c = jsonPeek(s);
+    if (c == ']') {
+        s->pos++;
+        return false;
+    }
+    if (c < 0) return fail(s);
+    if (!*first && !jsonExpect(s, ',')) return false;
+    *first = false;
+    return true;
+}
+
+static int hexValue(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void appendByte(char* out, size_t outSize, size_t* len, int c) {
+    if (out && *len + 1 < outSize) out[*len] = (char)c;
+    (*len)++;
+}
+
+// Encodes a \uXXXX escape as UTF-8 (surrogate pairs are not combined)
+static void appendCodepoint(char* out, size_t outSize, size_t* len, unsigned int cp) {
+    if (cp < 0x80) {
+        appendByte(out, outSize, len, cp);
+    } else if (cp < 0x800) {
+        appendByte(out, outSize, len, 0xC0 | (cp >> 6));
+        appendByte(out, outSize, len, 0x80 | (cp & 0x3F));
+    } else {
+        appendByte(out, outSize, len, 0xE0 | (cp >> 12));
+        appendByte(out, outSize, len, 0x80 | ((cp >> 6) & 0x3F));
+        appendByte(out, outSize, len, 0x80 | (cp & 0x3F));
+    }
+}
+
+bool jsonReadString(JsonStream* s, char* out, size_t outSize) {
+    if (!jsonExpect(s, '"')) return false;
+
+    size_t len = 0;
+    for (;;) {
+        int c = nextRaw(s);
+        if (c < 0) return fail(s);
+        if (c == '"') break;
+
+        if (c == '\\') {
+            c = nextRaw(s);
+            switch (c) {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': {
+                    unsigned int cp = 0;
+                    for (int i = 0; i < 4; i++) {
+                        int h = hexValue(nextRaw(s));
+                        if (h < 0) return fail(s);
+                        cp = (cp << 4) | h;
+                    }
+                    appendCodepoint(out, outSize, &len, cp);
+                    continue;
+                }
+                case '"': case '\\': case '/': break;
+                default: return fail(s);
+            }
+        }
+        appendByte(out, outSize, &len, c);
+    }
+
+    if (out && outSize > 0) out[len < outSize ? len : outSize - 1] = '\0';
+    return true;
+}
+
+bool jsonReadOptionalString(JsonStream* s, char* out, size_t outSize) {
+    if (jsonPeek(s) == '"') return jsonReadString(s, out, outSize);
+    if (outSize > 0) out[0] = '\0';
+    return jsonSkipValue(s);
+}
+
+bool jsonReadNumber(JsonStream* s, double* value) {
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    int c = jsonPeek(s);
+    bool negative = false;
+    if (c == '-') {
+        negative = true;
+        s->pos++;
+        c = peekRaw(s);
+    }
+    if (c < '0' || c > '9') return fail(s);
+
+    // Accumulate up to 19 significant digits, then fold in the exponent
+    unsigned long long mantissa = 0;
+    int digits = 0, exponent = 0;
+
+    while ((c = peekRaw(s)) >= '0' && c <= '9') {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (c - '0');
+            if (mantissa) digits++;
+        } else {
+            exponent++;
+        }
+        s->pos++;
+    }
+    if (c == '.') {
+        s->pos++;
+        while ((c = peekRaw(s)) >= '0' && c <= '9') {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (c - '0');
+                if (mantissa) digits++;
+                exponent--;
+            }
+            s->pos++;
+        }
+    }
+    if (c == 'e' || c == 'E') {
+        s->pos++;
+        c = peekRaw(s);
+        bool expNegative = c == '-';
+        if (c == '-' || c == '+') s->pos++;
+        int e = 0;
+        while ((c = peekRaw(s)) >= '0' && c <= '9') {
+            if (e < 10000) e = e * 10 + (c - '0');
+            s->pos++;
+        }
+        exponent += expNegative ? -e : e;
+    }
+
+    double v = (double)mantissa;
+    while (exponent > 22) { v *= 1e22; exponent -= 22; }
+    while (exponent < -22) { v /= 1e22; exponent += 22; }
+    v = exponent >= 0 ? v * powers[exponent] : v / powers[-exponent];
+
+    *value = negative ? -v : v;
+    return true;
+}
+
+static bool expectLiteral(JsonStream* s, const char* literal) {
+    for (const char* p = literal; *p; p++) {
+        if (nextRaw(s) != (unsigned char)*p) return fail(s);
+    }
+    return true;
+}
+
+bool jsonSkipValue(JsonStream* s) {
+    int c = jsonPeek(s);
+    switch (c) {
+        case '"':
+            return jsonReadString(s, NULL, 0);
+        case '{': {
+            s->pos++;
+            bool first = true;
+            char key[8];
+            while (jsonNextKey(s, &first, key, sizeof(key))) {
+                if (!jsonSkipValue(s)) return false;
+            }
+            return !s->failed;
+        }
+        case '[': {
+            s->pos++;
+            bool first = true;
+            while (jsonNextElement(s, &first)) {
+                if (!jsonSkipValue(s)) return false;
+            }
+            return !s->failed;
+        }
+        case 't': return expectLiteral(s, "true");
+        case 'f': return expectLiteral(s, "false");
+        case 'n': return expectLiteral(s, "null");
+        default: {
+            double ignored;
+            return jsonReadNumber(s, &ignored);
+        }
+    }
+}
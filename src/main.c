@@ -1,111 +1,261 @@
 #include "map_utils.h"
+#include "map_loader.h"
+#include "country_search.h"
+#include "map_mesh.h"
+#include "map_layer.h"
+#include "map_tiles.h"
+#include "flag_loader.h"
+#include "background.h"
+#include "picking.h"
+#include "profiler.h"
+#include "status_store.h"
+#include "render_cli.h"
+#include "platform.h"
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
 
-void loadCountryFlag(WorldMap* map, int countryIndex) {
-    if (map->flags[countryIndex].loaded) return;
-    
-    char flagPath[512];
-    snprintf(flagPath, sizeof(flagPath), "assets/flags/%s.svg", 
-             map->countries[countryIndex].iso_code);
-    
-    map->flags[countryIndex].texture = LoadTexture(flagPath);
-    map->flags[countryIndex].loaded = true;
-    
-    if (map->flags[countryIndex].texture.id == 0) {
-        printf("Warning: Could not load flag for %s (%s)\n", 
-               map->countries[countryIndex].name,
-               map->countries[countryIndex].iso_code);
-        map->flags[countryIndex].loaded = false;
-    }
+#define MIN_ZOOM 0.1f
+#define MAX_ZOOM 25.0f
+#define INFO_PANEL_HEIGHT 120
+
+#define SEARCH_BOX_WIDTH 320
+#define SEARCH_BOX_HEIGHT 30
+#define SEARCH_RESULT_HEIGHT 26
+
+typedef struct {
+    char text[64];          // UTF-8
+    int length;
+    bool active;            // Has keyboard focus
+    int results[COUNTRY_SEARCH_MAX_RESULTS];
+    int resultCount;
+    int highlighted;
+} SearchBox;
+
+static Rectangle getSearchBoxRect(void) {
+    return (Rectangle){ (SCREEN_WIDTH - SEARCH_BOX_WIDTH) / 2.0f, 10, SEARCH_BOX_WIDTH, SEARCH_BOX_HEIGHT };
 }
 
-void drawNebulaSkyBackground(Shader starShader, float timeValue) {
-    int timeLoc = GetShaderLocation(starShader, "time");
-    int screenWidthLoc = GetShaderLocation(starShader, "screenWidth");
-    int screenHeightLoc = GetShaderLocation(starShader, "screenHeight");
+static Rectangle getSearchResultRect(int i) {
+    Rectangle box = getSearchBoxRect();
+    return (Rectangle){ box.x, box.y + box.height + i * SEARCH_RESULT_HEIGHT, box.width, SEARCH_RESULT_HEIGHT };
+}
 
-    if (timeLoc != -1) {
-        SetShaderValue(starShader, timeLoc, &timeValue, SHADER_UNIFORM_FLOAT);
+static void setSearchActive(SearchBox* box, bool active) {
+    box->active = active;
+    // Escape closes the box rather than the window while it has focus
+    SetExitKey(active ? KEY_NULL : KEY_ESCAPE);
+    if (active) {
+        while (GetCharPressed() > 0) {}     // Drop the key that opened it
+    } else {
+        box->text[0] = '\0';
+        box->length = 0;
+        box->resultCount = 0;
+    }
+}
+
+// Keyboard input while the box has focus; returns the country picked with
+// Enter, or -1
+static int updateSearchBox(SearchBox* box, const CountrySearch* search) {
+    if (!box->active) return -1;
+
+    bool changed = false;
+    int codepoint;
+    while ((codepoint = GetCharPressed()) > 0) {
+        int size = 0;
+        const char* utf8 = CodepointToUTF8(codepoint, &size);
+        if (box->length + size >= (int)sizeof(box->text)) continue;
+        memcpy(box->text + box->length, utf8, size);
+        box->length += size;
+        box->text[box->length] = '\0';
+        changed = true;
+    }
+    if (IsKeyPressed(KEY_BACKSPACE) && box->length > 0) {
+        // Back over a whole UTF-8 sequence
+        do {
+            box->length--;
+        } while (box->length > 0 && ((unsigned char)box->text[box->length] & 0xC0) == 0x80);
+        box->text[box->length] = '\0';
+        changed = true;
+    }
+    if (changed) {
+        box->resultCount = searchCountries(search, box->text, box->results, COUNTRY_SEARCH_MAX_RESULTS);
+        box->highlighted = 0;
     }
 
-    float screenWidth = (float)SCREEN_WIDTH;
-    float screenHeight = (float)SCREEN_HEIGHT;
+    if (IsKeyPressed(KEY_DOWN) && box->highlighted + 1 < box->resultCount) box->highlighted++;
+    if (IsKeyPressed(KEY_UP) && box->highlighted > 0) box->highlighted--;
+    if (IsKeyPressed(KEY_ESCAPE)) setSearchActive(box, false);
+    if (IsKeyPressed(KEY_ENTER) && box->resultCount > 0) return box->results[box->highlighted];
+    return -1;
+}
 
-    if (screenWidthLoc != -1) {
-        SetShaderValue(starShader, screenWidthLoc, &screenWidth, SHADER_UNIFORM_FLOAT);
+static void drawSearchBox(const SearchBox* box, const WorldMap* map) {
+    Rectangle rect = getSearchBoxRect();
+    DrawRectangleRec(rect, UI_PANEL_COLOR);
+    DrawRectangleLinesEx(rect, 1, box->active ? WHITE : GRAY);
+    if (box->length > 0 || box->active) {
+        DrawText(TextFormat("%s%s", box->text, box->active ? "_" : ""), rect.x + 8, rect.y + 6, 20, WHITE);
+    } else {
+        DrawText("Search countries (/)", rect.x + 8, rect.y + 6, 20, GRAY);
     }
 
-    if (screenHeightLoc != -1) {
-        SetShaderValue(starShader, screenHeightLoc, &screenHeight, SHADER_UNIFORM_FLOAT);
+    for (int i = 0; box->active && i < box->resultCount; i++) {
+        const Country* country = &map->countries[box->results[i]];
+        Rectangle row = getSearchResultRect(i);
+        DrawRectangleRec(row, i == box->highlighted ? Fade(STATUS_BEEN_COLOR, 0.6f) : UI_PANEL_COLOR);
+        DrawText(country->name, row.x + 8, row.y + 4, 20, WHITE);
+        DrawText(TextToUpper(country->iso_code), row.x + row.width - 36, row.y + 4, 20, LIGHTGRAY);
     }
+}
 
-    BeginShaderMode(starShader);
-    DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, WHITE);
-    EndShaderMode();
+// Zoom, and centre in world units (screen pixels at zoom 1), that fit the
+// country's bounds into the view above the info panel with some margin
+static bool frameCountry(const WorldMap* map, int countryIndex, float* zoom, Vector2* center) {
+    Rectangle bounds = getCountryBounds(map, countryIndex);
+    if (bounds.width <= 0.0f && bounds.height <= 0.0f) return false;
+
+    float left = longitudeToScreenX(bounds.x, 1.0f, 0.0f);
+    float right = longitudeToScreenX(bounds.x + bounds.width, 1.0f, 0.0f);
+    float top = latitudeToScreenY(bounds.y + bounds.height, 1.0f, 0.0f);
+    float bottom = latitudeToScreenY(bounds.y, 1.0f, 0.0f);
+
+    float fitX = SCREEN_WIDTH * 0.8f / fmaxf(right - left, 0.001f);
+    float fitY = (SCREEN_HEIGHT - INFO_PANEL_HEIGHT) * 0.8f / fmaxf(bottom - top, 0.001f);
+    *zoom = fminf(fmaxf(fminf(fitX, fitY), MIN_ZOOM), MAX_ZOOM);
+    *center = (Vector2){ (left + right) / 2.0f, (top + bottom) / 2.0f };
+    return true;
 }
+
+// Shown while the map loads; the background keeps animating behind it
+static void drawLoadingScreen(const char* stage, float progress) {
+    const int barWidth = 400;
+    const int barHeight = 12;
+    int x = (SCREEN_WIDTH - barWidth) / 2;
+    int y = SCREEN_HEIGHT / 2;
+    DrawText("Loading map", x, y - 50, 30, WHITE);
+    DrawRectangle(x, y, barWidth, barHeight, UI_PANEL_COLOR);
+    DrawRectangle(x, y, (int)(barWidth * progress), barHeight, STATUS_BEEN_COLOR);
+    DrawRectangleLines(x, y, barWidth, barHeight, WHITE);
+    DrawText(stage, x, y + 24, 20, WHITE);
+}
+
 // Add this helper function to your map_utils.h
 float lerp(float a, float b, float t) {
     return a + (b - a) * t;
 }
 
 // Complete main function with smooth zooming
-int main(void) {
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Traveltint");
-    SetTargetFPS(60);
-
+int main(int argc, char** argv) {
+    markStartup();
     #ifndef PLATFORM_WEB
-    Shader starShader = LoadShader("shaders/stars.vs", "shaders/stars.fs");
-    bool useShader = starShader.id != 0;
-    
-    if (!useShader) {
-        printf("ERROR: Shader failed to compile!\n");
-    } else {
-        int timeLoc = GetShaderLocation(starShader, "time");
-        int screenSizeLoc = GetShaderLocation(starShader, "screenWidth");
-        int screenHeightLoc = GetShaderLocation(starShader, "screenHeight");
+    if (isRenderCommand(argc, argv)) return runRenderCommand(argc, argv);
+    #else
+    (void)argc;
+    (void)argv;
+    #endif
 
-        printf("Time Location: %d\n", timeLoc);
-        printf("Screen Width Location: %d\n", screenSizeLoc);
-        printf("Screen Height Location: %d\n", screenHeightLoc);
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Traveltint");
+    SetTargetFPS(60);
 
-        if (timeLoc == -1 || screenSizeLoc == -1 || screenHeightLoc == -1) {
-            printf("ERROR: Failed to get shader uniform locations!\n");
-            useShader = false;
+    Background* background = loadBackground(BACKGROUND_QUALITY_MEDIUM);
+
+    // Threaded builds load the map in the background behind a progress
+    // screen; statuses are read meanwhile
+    MapLoader* mapLoader = startMapLoad("assets/world.geojson");
+    mountPersistentStorage();
+    CountryStatusList* statusList = LoadCountryStatuses(STATUS_FILE_PATH);
+    StatusJournal* statusJournal = openStatusJournal(STATUS_FILE_PATH, statusList);
+
+    const char* loadStage = "";
+    float loadProgress = 0.0f;
+    bool closed = false;
+    while (!pollMapLoad(mapLoader, &loadStage, &loadProgress)) {
+        if (WindowShouldClose()) {
+            closed = true;
+            break;
         }
+        double time = GetTime();
+        updateBackground(background, time);
+        BeginDrawing();
+        drawBackground(background, time);
+        drawLoadingScreen(loadStage, loadProgress);
+        EndDrawing();
     }
-    #else
-    bool useShader = false;
-    #endif
-
-    RenderTexture2D starTarget = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
 
-    WorldMap* map = loadWorldMap("assets/world.geojson");
-    if (!map) {
+    double loadMilliseconds = 0.0;
+    WorldMap* map = finishMapLoad(mapLoader, &loadMilliseconds);
+    if (!map || closed) {
+        if (statusJournal) closeStatusJournal(statusJournal);
+        free(statusList->statuses);
+        free(statusList);
+        if (map) unloadWorldMap(map);
+        unloadBackground(background);
         CloseWindow();
-        return 1;
+        return map ? 0 : 1;
     }
+    printf("Map loaded in %.0f ms (%s)\n", loadMilliseconds, PLATFORM_VARIANT);
+
+    #ifndef PLATFORM_WEB
+    MapMesh* mapMesh = loadMapMesh(map);
+    #else
+    MapMesh* mapMesh = NULL;
+    #endif
+    MapLayer* mapLayer = loadMapLayer(GetScreenWidth(), GetScreenHeight());
+    MapTiles* mapTiles = loadMapTiles(map, 0);
+    #ifndef PLATFORM_WEB
+    FlagLoader* flagLoader = loadFlagLoader(map, FLAG_CACHE_DIR, 0);
+    #else
+    FlagLoader* flagLoader = loadFlagLoader(map, NULL, 0);  // Fetched SVGs are cached in IndexedDB instead
+    #endif
 
     // Add these variables for smooth zooming
     float targetZoom = map->zoom;
     float zoomSmoothFactor = 0.2f;  // Lower = smoother but slower transitions
 
-    CountryStatusList* statusList = LoadCountryStatuses("country_statuses.dat");
-    char clickedCountry[256] = "";
+    // Fly-to: the view centre eases toward flyCenter while zoom eases
+    // toward targetZoom; any pan or zoom input cancels it
+    bool flying = false;
+    Vector2 flyCenter = {0, 0};
+
+    CountrySearch* countrySearch = buildCountrySearch(map);
+    SearchBox searchBox = {0};
+
+    int selectedCountry = -1;   // Country index, -1 for none
+    syncMapMeshColors(mapMesh, map, selectedCountry, statusList);
     Vector2 dragStart = {0, 0};
     bool isDragging = false;
     Vector2 prevDragPos = {0, 0};
     bool isUIClick = false;
+    bool showProfiler = false;
+    bool firstMapShown = false;
 
     while (!WindowShouldClose()) {
+        PROF_BEGIN(PROF_INPUT);
         isUIClick = false;
 
-        if (IsKeyDown(KEY_RIGHT)) map->offset.x -= 5.0f;
-        if (IsKeyDown(KEY_LEFT)) map->offset.x += 5.0f;
-        if (IsKeyDown(KEY_DOWN)) map->offset.y -= 5.0f;
-        if (IsKeyDown(KEY_UP)) map->offset.y += 5.0f;
+        // While the search box has focus the keyboard belongs to it
+        int searchPick = updateSearchBox(&searchBox, countrySearch);
+        if (!searchBox.active) {
+            if (IsKeyDown(KEY_RIGHT)) map->offset.x -= 5.0f;
+            if (IsKeyDown(KEY_LEFT)) map->offset.x += 5.0f;
+            if (IsKeyDown(KEY_DOWN)) map->offset.y -= 5.0f;
+            if (IsKeyDown(KEY_UP)) map->offset.y += 5.0f;
+            if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_UP)) flying = false;
+
+            if (IsKeyPressed(KEY_B)) {
+                setBackgroundQuality(background, (background->quality + 1) % BACKGROUND_QUALITY_COUNT);
+            }
+            if (IsKeyPressed(KEY_SLASH)) setSearchActive(&searchBox, true);
+        }
+        if (IsKeyPressed(KEY_F3)) showProfiler = !showProfiler;
+        if (IsKeyPressed(KEY_F4)) {
+            #ifndef PLATFORM_WEB
+            if (exportProfileTrace("profile_trace.json", PROFILE_TRACE_FRAMES)) printf("Wrote profile_trace.json\n");
+            #endif
+            printProfileSummary(PLATFORM_VARIANT);
+        }
         
         // Updated mouse wheel zoom handling
         float wheel = GetMouseWheelMove();
@@ -121,12 +271,33 @@ int main(void) {
             targetZoom *= zoomFactor;
             
             // Apply limits
-            if (targetZoom < 0.1f) targetZoom = 0.1f;
-            if (targetZoom > 25.0f) targetZoom = 25.0f;
+            if (targetZoom < MIN_ZOOM) targetZoom = MIN_ZOOM;
+            if (targetZoom > MAX_ZOOM) targetZoom = MAX_ZOOM;
+            flying = false;
         }
 
         // Apply smooth zooming - do this BEFORE drawing
-        if (fabsf(targetZoom - map->zoom) > 0.001f) {
+        if (flying) {
+            // Keep the centre of the view above the panel on the flight path
+            Vector2 viewCenter = { SCREEN_WIDTH / 2.0f, (SCREEN_HEIGHT - INFO_PANEL_HEIGHT) / 2.0f };
+            Vector2 center = {
+                (viewCenter.x - map->offset.x) / map->zoom,
+                (viewCenter.y - map->offset.y) / map->zoom
+            };
+            center.x = lerp(center.x, flyCenter.x, zoomSmoothFactor);
+            center.y = lerp(center.y, flyCenter.y, zoomSmoothFactor);
+            map->zoom = lerp(map->zoom, targetZoom, zoomSmoothFactor);
+
+            // Land exactly once the remaining move is under a pixel
+            float remaining = fmaxf(fabsf(center.x - flyCenter.x), fabsf(center.y - flyCenter.y)) * map->zoom;
+            if (remaining < 0.5f && fabsf(targetZoom - map->zoom) < 0.001f) {
+                map->zoom = targetZoom;
+                center = flyCenter;
+                flying = false;
+            }
+            map->offset.x = viewCenter.x - center.x * map->zoom;
+            map->offset.y = viewCenter.y - center.y * map->zoom;
+        } else if (fabsf(targetZoom - map->zoom) > 0.001f) {
             // Store mouse position in world coordinates
             Vector2 mousePos = GetMousePosition();
             Vector2 worldPos = {
@@ -146,32 +317,39 @@ int main(void) {
             Vector2 mousePos = GetMousePosition();
             isUIClick = false;
 
-            if (clickedCountry[0] != '\0' && mousePos.y > SCREEN_HEIGHT - 120) {
+            if (CheckCollisionPointRec(mousePos, getSearchBoxRect())) {
                 isUIClick = true;
-                int selectedIndex = -1;
-                for (int i = 0; i < map->countryCount; i++) {
-                    if (strcmp(map->countries[i].name, clickedCountry) == 0) {
-                        selectedIndex = i;
+                if (!searchBox.active) setSearchActive(&searchBox, true);
+            } else if (searchBox.active) {
+                for (int i = 0; i < searchBox.resultCount; i++) {
+                    if (CheckCollisionPointRec(mousePos, getSearchResultRect(i))) {
+                        searchPick = searchBox.results[i];
+                        isUIClick = true;
                         break;
                     }
                 }
+                if (!isUIClick) setSearchActive(&searchBox, false);
+            }
+
+            if (!isUIClick && selectedCountry >= 0 && mousePos.y > SCREEN_HEIGHT - INFO_PANEL_HEIGHT) {
+                isUIClick = true;
 
-                if (selectedIndex >= 0) {
-                    float buttonX = 100;
-                    for (int i = 0; i < 4; i++) {
-                        Rectangle btn = {buttonX, SCREEN_HEIGHT - 40, 20, 20};
-                        if (CheckCollisionPointRec(mousePos, btn)) {
-                            int status = i;
-                            UpdateCountryStatus(statusList, map->countries[selectedIndex].iso_code, status);
-                            SaveCountryStatuses("country_statuses.dat", statusList);
-                            break;
-                        }
-                        buttonX += 150;
+                float buttonX = 100;
+                for (int i = 0; i < 4; i++) {
+                    Rectangle btn = {buttonX, SCREEN_HEIGHT - 40, 20, 20};
+                    if (CheckCollisionPointRec(mousePos, btn)) {
+                        int status = i;
+                        UpdateCountryStatus(statusList, map->countries[selectedCountry].iso_code, status);
+                        appendStatusJournal(statusJournal, map->countries[selectedCountry].iso_code, status);
+                        updateMapMeshColor(mapMesh, selectedCountry, getCountryColor(status, true));
+                        break;
                     }
+                    buttonX += 150;
                 }
             }
 
             if (!isUIClick) {
+                flying = false;
                 dragStart = mousePos;
                 isDragging = true;
                 prevDragPos = dragStart;
@@ -192,98 +370,83 @@ int main(void) {
             float dragDistance = sqrt(pow(endPos.x - dragStart.x, 2) + pow(endPos.y - dragStart.y, 2));
             if (dragDistance < 5.0f) {
                 Vector2 clickPos = GetMousePosition();
-     
-                for (int i = 0; i < map->countryCount; i++) {
-                    Country* country = &map->countries[i];
-                    bool found = false;
-                    
-                    for (int p = 0; p < country->polygonCount; p++) {
-                        Polygon* poly = &map->polygons[country->polygonStart + p];
-                        Vector2* screenPoints = (Vector2*)malloc(poly->numPoints * sizeof(Vector2));
-                        
-                        for (int j = 0; j < poly->numPoints; j++) {
-                            screenPoints[j] = (Vector2){
-                                longitudeToScreenX(poly->points[j].x, map->zoom, map->offset.x),
-                                latitudeToScreenY(poly->points[j].y, map->zoom, map->offset.y)
-                            };
-                        }
-
-                        if (CheckCollisionPointPoly(clickPos, screenPoints, poly->numPoints)) {
-                            strncpy(clickedCountry, country->name, sizeof(clickedCountry) - 1);
-                            clickedCountry[sizeof(clickedCountry) - 1] = '\0';
-                            free(screenPoints);
-                            found = true;
-                            break;
-                        }
-                        free(screenPoints);
-                    }
-                    if (found) break;
+                PROF_BEGIN(PROF_PICKING);
+                int countryIndex = pickCountryAt(map, clickPos);
+                PROF_END(PROF_PICKING);
+
+                if (countryIndex >= 0 && countryIndex != selectedCountry) {
+                    selectedCountry = countryIndex;
+                    syncMapMeshColors(mapMesh, map, selectedCountry, statusList);
                 }
             }
         }
 
+        // A search result selects the country and flies the camera to it
+        if (searchPick >= 0) {
+            setSearchActive(&searchBox, false);
+            if (searchPick != selectedCountry) {
+                selectedCountry = searchPick;
+                syncMapMeshColors(mapMesh, map, selectedCountry, statusList);
+            }
+            flying = frameCountry(map, selectedCountry, &targetZoom, &flyCenter);
+        }
+
+        PROF_END(PROF_INPUT);
+
+        // The writer may still hold the change; persist once it is on file
+        if (takeStatusJournalFlush(statusJournal)) syncPersistentStorage();
+
+        double time = GetTime();
+        updateBackground(background, time);
+        updateFlagLoader(flagLoader, map);
+
+        PROF_BEGIN(PROF_MAP_LAYER);
+        // Deep zoom draws cached tiles once they cover the view
+        bool useTiles = updateMapTiles(mapTiles, map, statusList);
+        if (!useTiles) updateMapLayer(mapLayer, map, mapMesh, selectedCountry, statusList);
+        PROF_END(PROF_MAP_LAYER);
+
         BeginDrawing();
-        ClearBackground(SPACE_BG_COLOR);
+        drawBackground(background, time);
 
-        if (useShader) {
-            #ifndef PLATFORM_WEB
-            float timeValue = (float)GetTime();
-            drawNebulaSkyBackground(starShader, timeValue);
-            #endif
+        if (useTiles) {
+            drawMapTiles(mapTiles, map);
+            drawWorldMapCountry(map, selectedCountry, statusList);
+        } else {
+            drawMapLayer(mapLayer);
         }
 
-        drawWorldMap(map, clickedCountry, statusList);
-
-        if (clickedCountry[0] != '\0') {
-            int selectedIndex = -1;
-            for (int i = 0; i < map->countryCount; i++) {
-                if (strcmp(map->countries[i].name, clickedCountry) == 0) {
-                    selectedIndex = i;
-                    break;
-                }
+        PROF_BEGIN(PROF_UI);
+        if (selectedCountry >= 0) {
+            requestCountryFlag(flagLoader, map, selectedCountry);
+            DrawRectangle(0, SCREEN_HEIGHT - INFO_PANEL_HEIGHT, SCREEN_WIDTH, INFO_PANEL_HEIGHT, UI_PANEL_COLOR);
+            Texture2D flagAtlas;
+            Rectangle flagSource;
+            if (getCountryFlag(flagLoader, selectedCountry, &flagAtlas, &flagSource)) {
+                // Already rasterized to fit the FLAG_MAX_WIDTH x FLAG_MAX_HEIGHT box
+                float y = SCREEN_HEIGHT - 110 + (80 - flagSource.height) / 2;
+                DrawTextureRec(flagAtlas, flagSource, (Vector2){10, roundf(y)}, WHITE);
             }
 
-            if (selectedIndex >= 0) {
-                loadCountryFlag(map, selectedIndex);
-                DrawRectangle(0, SCREEN_HEIGHT - 120, SCREEN_WIDTH, 120, UI_PANEL_COLOR);
-                if (map->flags[selectedIndex].loaded) {
-                    float maxHeight = 40;
-                    float maxWidth = 60;
-                    float origWidth = (float)map->flags[selectedIndex].texture.width;
-                    float origHeight = (float)map->flags[selectedIndex].texture.height;
-                    float scale = fmin(maxWidth / origWidth, maxHeight / origHeight);
-                    float finalWidth = origWidth * scale;
-                    float finalHeight = origHeight * scale;
-                    float y = SCREEN_HEIGHT - 110 + (80 - finalHeight) / 2;
-                    
-                    DrawTexturePro(
-                        map->flags[selectedIndex].texture,
-                        (Rectangle){0, 0, origWidth, origHeight},
-                        (Rectangle){10, y, finalWidth, finalHeight},
-                        (Vector2){0, 0}, 0, WHITE
-                    );
-                }
-
-                DrawText(clickedCountry, 180, SCREEN_HEIGHT - 100, 30, WHITE);
+            DrawText(map->countries[selectedCountry].name, 180, SCREEN_HEIGHT - 100, 30, WHITE);
 
-                int currentStatus = GetCountryStatus(statusList, map->countries[selectedIndex].iso_code);
-                DrawText("Status:", 10, SCREEN_HEIGHT - 40, 20, WHITE);
-                                
-                const char* labels[] = {"None", "Been", "Lived", "Want"};
-                Color colors[] = {STATUS_NONE_COLOR, STATUS_BEEN_COLOR, STATUS_LIVED_COLOR, STATUS_WANT_COLOR};
+            int currentStatus = GetCountryStatus(statusList, map->countries[selectedCountry].iso_code);
+            DrawText("Status:", 10, SCREEN_HEIGHT - 40, 20, WHITE);
+                            
+            const char* labels[] = {"None", "Been", "Lived", "Want"};
+            Color colors[] = {STATUS_NONE_COLOR, STATUS_BEEN_COLOR, STATUS_LIVED_COLOR, STATUS_WANT_COLOR};
 
-                float buttonX = 100;
+            float buttonX = 100;
 
-                for (int i = 0; i < 4; i++) {
-                    Rectangle btn = {buttonX, SCREEN_HEIGHT - 40, 20, 20};
-                    DrawRectangleRec(btn, colors[i]);
-                    if (currentStatus == i) {
-                        DrawRectangle(buttonX + 5, SCREEN_HEIGHT - 35, 10, 10, WHITE);
-                    }
-                    DrawRectangleLinesEx(btn, 1, WHITE);
-                    DrawText(labels[i], buttonX + 30, SCREEN_HEIGHT - 40, 20, WHITE);
-                    buttonX += 150;
+            for (int i = 0; i < 4; i++) {
+                Rectangle btn = {buttonX, SCREEN_HEIGHT - 40, 20, 20};
+                DrawRectangleRec(btn, colors[i]);
+                if (currentStatus == i) {
+                    DrawRectangle(buttonX + 5, SCREEN_HEIGHT - 35, 10, 10, WHITE);
                 }
+                DrawRectangleLinesEx(btn, 1, WHITE);
+                DrawText(labels[i], buttonX + 30, SCREEN_HEIGHT - 40, 20, WHITE);
+                buttonX += 150;
             }
         }
 
@@ -291,22 +454,49 @@ int main(void) {
         DrawText("Use arrow keys to pan", 10, 30, 20, WHITE);
         DrawText("Use mouse wheel to zoom", 10, 50, 20, WHITE);
         DrawText("Click and drag to pan", 10, 70, 20, WHITE);
+        DrawText(TextFormat("B: background (%s)", getBackgroundTier(background->quality)->name), 10, 90, 20, WHITE);
+        #if TT_PROFILE
+        #ifndef PLATFORM_WEB
+        DrawText("F3: profiler, F4: save trace", 10, 110, 20, WHITE);
+        #else
+        DrawText("F3: profiler, F4: print timings", 10, 110, 20, WHITE);
+        #endif
+        #endif
+        drawSearchBox(&searchBox, map);
+        PROF_END(PROF_UI);
+
+        if (showProfiler) drawProfileOverlay(SCREEN_WIDTH - PROFILE_OVERLAY_FRAMES - 30, 10);
 
         EndDrawing();
+        profileFrameEnd();
+
+        if (!firstMapShown) {
+            firstMapShown = true;
+            double transferred = getTransferredBytes();
+            if (transferred >= 0) {
+                printf("First map after %.0f ms, %.1f KB transferred (%s)\n", getStartupMilliseconds(), transferred / 1024.0, PLATFORM_VARIANT);
+            } else {
+                printf("First map after %.0f ms (%s)\n", getStartupMilliseconds(), PLATFORM_VARIANT);
+            }
+        }
     }
 
-    SaveCountryStatuses("country_statuses.dat", statusList);
+    if (statusJournal) {
+        closeStatusJournal(statusJournal);
+    } else {
+        SaveCountryStatuses(STATUS_FILE_PATH, statusList);
+    }
+    syncPersistentStorage();
     free(statusList->statuses);
     free(statusList);
+    unloadCountrySearch(countrySearch);
+    unloadFlagLoader(flagLoader);
+    unloadMapTiles(mapTiles);
+    unloadMapLayer(mapLayer);
+    unloadMapMesh(mapMesh);
     unloadWorldMap(map);
+    unloadBackground(background);
     
-    #ifndef PLATFORM_WEB
-    if (useShader) {
-        UnloadShader(starShader);
-    }
-    #endif
-    
-    UnloadRenderTexture(starTarget);
     CloseWindow();
     return 0;
 }
\ No newline at end of file
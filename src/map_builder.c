@@ -0,0 +1,276 @@
+#include "map_builder.h"
+#include "triangulate.h"
+#include "map_lod.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <ctype.h>
+
+static bool growArray(void** array, int* capacity, int needed, size_t elementSize) {
+    if (needed <= *capacity) return true;
+    int newCapacity = *capacity > 0 ? *capacity * 2 : 256;
+    while (newCapacity < needed) newCapacity *= 2;
+    void* grown = realloc(*array, newCapacity * elementSize);
+    if (!grown) return false;
+    *array = grown;
+    *capacity = newCapacity;
+    return true;
+}
+
+// Polygons, their bounds and their owners always grow together
+static bool growPolygons(MapBuilder* builder, int needed) {
+    WorldMap* map = builder->map;
+    int capacity = builder->polygonCapacity;
+    int boundsCapacity = capacity, ownersCapacity = capacity;
+    if (!growArray((void**)&map->polygons, &capacity, needed, sizeof(Polygon)) ||
+        !growArray((void**)&map->polygonBounds, &boundsCapacity, needed, sizeof(PolygonBounds)) ||
+        !growArray((void**)&map->polygonCountry, &ownersCapacity, needed, sizeof(int))) return false;
+    builder->polygonCapacity = capacity;
+    return true;
+}
+
+bool mapBuilderInit(MapBuilder* builder) {
+    memset(builder, 0, sizeof(*builder));
+    builder->map = (WorldMap*)calloc(1, sizeof(WorldMap));
+    if (!builder->map) return false;
+    builder->map->zoom = 1.0f;
+    return true;
+}
+
+void mapBuilderBeginRing(MapBuilder* builder) {
+    builder->map->numPoints = builder->committedPoints;
+}
+
+bool mapBuilderAddPoint(MapBuilder* builder, Vector2 point) {
+    WorldMap* map = builder->map;
+    if (!growArray((void**)&map->points, &builder->pointCapacity, map->numPoints + 1, sizeof(Vector2))) return false;
+    map->points[map->numPoints++] = point;
+    return true;
+}
+
+bool mapBuilderCommitRing(MapBuilder* builder) {
+    WorldMap* map = builder->map;
+    int start = builder->committedPoints;
+    int count = map->numPoints - start;
+    if (count == 0) return true;
+
+    if (!growPolygons(builder, map->numPolygons + 1)) return false;
+
+    const Vector2* points = map->points + start;
+    Rectangle bounds = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (int j = 0; j < count; j++) {
+        if (points[j].x < bounds.x) bounds.x = points[j].x;
+        if (points[j].x > bounds.width) bounds.width = points[j].x;
+        if (points[j].y < bounds.y) bounds.y = points[j].y;
+        if (points[j].y > bounds.height) bounds.height = points[j].y;
+    }
+    bounds.width -= bounds.x;
+    bounds.height -= bounds.y;
+
+    Polygon* poly = &map->polygons[map->numPolygons];
+    poly->pointStart = start;
+    poly->numPoints = count;
+    poly->triangleStart = map->numTriangleIndices;
+    poly->numTriangles = 0;
+
+    if (count >= 3) {
+        if (!growArray((void**)&map->triangles, &builder->triangleCapacity, map->numTriangleIndices + 3 * (count - 2), sizeof(int)) ||
+            !growArray((void**)&builder->scratch, &builder->scratchCapacity, 2 * count, sizeof(int))) return false;
+        poly->numTriangles = triangulatePolygon(points, count, map->triangles + poly->triangleStart, builder->scratch);
+        map->numTriangleIndices += poly->numTriangles * 3;
+    }
+
+    // Cleared first so padding is deterministic in compiled map files
+    PolygonBounds* polygonBounds = &map->polygonBounds[map->numPolygons];
+    memset(polygonBounds, 0, sizeof(*polygonBounds));
+    polygonBounds->bounds = bounds;
+    polygonBounds->isVisible = true;
+    map->polygonCountry[map->numPolygons] = -1;
+    map->numPolygons++;
+    builder->committedPoints = map->numPoints;
+    return true;
+}
+
+static int findOrCreateCountry(MapBuilder* builder, const char* countryName, const char* isoCode, int polygonIndex) {
+    WorldMap* map = builder->map;
+
+    for (int i = 0; i < map->countryCount; i++) {
+        if (strcmp(map->countries[i].name, countryName) == 0) return i;
+    }
+
+    if (!growArray((void**)&map->countries, &builder->countryCapacity, map->countryCount + 1, sizeof(Country))) return -1;
+
+    Country* country = &map->countries[map->countryCount];
+    memset(country, 0, sizeof(Country));
+    strncpy(country->name, countryName, 255);
+    country->name[255] = '\0';
+    country->iso_code[0] = tolower((unsigned char)isoCode[0]);
+    country->iso_code[1] = tolower((unsigned char)isoCode[1]);
+    country->iso_code[2] = '\0';
+    country->isoKey = isoCodeKey(country->iso_code);
+    country->polygonStart = polygonIndex;
+    country->polygonCount = 0;
+    return map->countryCount++;
+}
+
+bool mapBuilderEndFeature(MapBuilder* builder, int firstPolygon, const char* name, const char* isoCode, bool valid) {
+    WorldMap* map = builder->map;
+
+    // Drop any trailing ring that was never committed
+    map->numPoints = builder->committedPoints;
+    if (map->numPolygons == firstPolygon) return true;
+
+    if (!valid) {
+        const Polygon* first = &map->polygons[firstPolygon];
+        map->numPoints = builder->committedPoints = first->pointStart;
+        map->numTriangleIndices = first->triangleStart;
+        map->numPolygons = firstPolygon;
+        return true;
+    }
+
+    int countryIdx = findOrCreateCountry(builder, name, isoCode, firstPolygon);
+    if (countryIdx < 0) return false;
+
+    for (int i = firstPolygon; i < map->numPolygons; i++) {
+        map->polygonCountry[i] = countryIdx;
+    }
+    map->countries[countryIdx].polygonCount += map->numPolygons - firstPolygon;
+    return true;
+}
+
+bool mapBuilderAppend(MapBuilder* builder, const MapBuilder* chunk) {
+    WorldMap* map = builder->map;
+    const WorldMap* source = chunk->map;
+    map->numPoints = builder->committedPoints;
+
+    int pointBase = map->numPoints;
+    int triangleBase = map->numTriangleIndices;
+    int polygonBase = map->numPolygons;
+    int pointCount = chunk->committedPoints;
+
+    if (!growPolygons(builder, polygonBase + source->numPolygons) ||
+        !growArray((void**)&map->points, &builder->pointCapacity, pointBase + pointCount, sizeof(Vector2)) ||
+        !growArray((void**)&map->triangles, &builder->triangleCapacity, triangleBase + source->numTriangleIndices, sizeof(int))) return false;
+
+    // Countries keep the order in which they first appear, as if the chunk's
+    // features had been read straight into this builder
+    int* remap = (int*)malloc((source->countryCount > 0 ? source->countryCount : 1) * sizeof(int));
+    if (!remap) return false;
+    for (int c = 0; c < source->countryCount; c++) {
+        const Country* country = &source->countries[c];
+        remap[c] = findOrCreateCountry(builder, country->name, country->iso_code, polygonBase + country->polygonStart);
+        if (remap[c] < 0) {
+            free(remap);
+            return false;
+        }
+        map->countries[remap[c]].polygonCount += country->polygonCount;
+    }
+
+    for (int i = 0; i < source->numPolygons; i++) {
+        Polygon poly = source->polygons[i];
+        poly.pointStart += pointBase;
+        poly.triangleStart += triangleBase;
+        map->polygons[polygonBase + i] = poly;
+        memcpy(&map->polygonBounds[polygonBase + i], &source->polygonBounds[i], sizeof(PolygonBounds));
+        map->polygonCountry[polygonBase + i] = remap[source->polygonCountry[i]];
+    }
+    free(remap);
+
+    memcpy(map->points + pointBase, source->points, pointCount * sizeof(Vector2));
+    memcpy(map->triangles + triangleBase, source->triangles, source->numTriangleIndices * sizeof(int));
+    map->numPolygons += source->numPolygons;
+    map->numPoints += pointCount;
+    map->numTriangleIndices += source->numTriangleIndices;
+    builder->committedPoints = map->numPoints;
+    return true;
+}
+
+static void freeBuilderArrays(MapBuilder* builder) {
+    WorldMap* map = builder->map;
+    free(map->countries);
+    free(map->polygons);
+    free(map->polygonBounds);
+    free(map->polygonCountry);
+    free(map->points);
+    free(map->triangles);
+    freeMapLevels(map);
+    free(builder->scratch);
+    builder->scratch = NULL;
+}
+
+// Copies a grown array into the arena and returns the new location
+static void* packArray(MapArena* arena, const void* data, size_t size) {
+    void* packed = arenaAlloc(arena, size);
+    if (packed && size > 0) memcpy(packed, data, size);
+    return packed;
+}
+
+WorldMap* mapBuilderFinish(MapBuilder* builder) {
+    WorldMap* map = builder->map;
+    map->numPoints = builder->committedPoints;
+
+    if (!buildMapLevels(map, builder->pool)) {
+        mapBuilderAbort(builder);
+        return NULL;
+    }
+
+    size_t countriesSize = map->countryCount * sizeof(Country);
+    size_t polygonsSize = map->numPolygons * sizeof(Polygon);
+    size_t boundsSize = map->numPolygons * sizeof(PolygonBounds);
+    size_t ownersSize = map->numPolygons * sizeof(int);
+    size_t pointsSize = map->numPoints * sizeof(Vector2);
+    size_t trianglesSize = map->numTriangleIndices * sizeof(int);
+
+    size_t total = arenaAlignSize(countriesSize) + arenaAlignSize(polygonsSize) +
+                   arenaAlignSize(boundsSize) + arenaAlignSize(ownersSize) +
+                   arenaAlignSize(pointsSize) + arenaAlignSize(trianglesSize);
+    for (int k = 1; k < MAP_LOD_LEVELS; k++) {
+        total += arenaAlignSize(polygonsSize) +
+                 arenaAlignSize(map->levels[k].numPoints * sizeof(Vector2)) +
+                 arenaAlignSize(map->levels[k].numTriangleIndices * sizeof(int));
+    }
+
+    MapArena arena;
+    if (!arenaInit(&arena, total)) {
+        mapBuilderAbort(builder);
+        return NULL;
+    }
+
+    Country* countries = (Country*)packArray(&arena, map->countries, countriesSize);
+    Polygon* polygons = (Polygon*)packArray(&arena, map->polygons, polygonsSize);
+    PolygonBounds* bounds = (PolygonBounds*)packArray(&arena, map->polygonBounds, boundsSize);
+    int* owners = (int*)packArray(&arena, map->polygonCountry, ownersSize);
+    Vector2* points = (Vector2*)packArray(&arena, map->points, pointsSize);
+    int* triangles = (int*)packArray(&arena, map->triangles, trianglesSize);
+
+    MapLevel levels[MAP_LOD_LEVELS];
+    levels[0] = (MapLevel){ map->levels[0].tolerance, polygons, points, map->numPoints, triangles, map->numTriangleIndices };
+    for (int k = 1; k < MAP_LOD_LEVELS; k++) {
+        const MapLevel* level = &map->levels[k];
+        levels[k] = *level;
+        levels[k].polygons = (Polygon*)packArray(&arena, level->polygons, polygonsSize);
+        levels[k].points = (Vector2*)packArray(&arena, level->points, level->numPoints * sizeof(Vector2));
+        levels[k].triangles = (int*)packArray(&arena, level->triangles, level->numTriangleIndices * sizeof(int));
+    }
+
+    freeBuilderArrays(builder);
+
+    map->countries = countries;
+    map->polygons = polygons;
+    map->polygonBounds = bounds;
+    map->polygonCountry = owners;
+    map->points = points;
+    map->triangles = triangles;
+    memcpy(map->levels, levels, sizeof(levels));
+    map->arena = arena;
+
+    builder->map = NULL;
+    return map;
+}
+
+void mapBuilderAbort(MapBuilder* builder) {
+    if (!builder->map) return;
+    freeBuilderArrays(builder);
+    free(builder->map);
+    builder->map = NULL;
+}
@@ -0,0 +1,270 @@
+#include "map_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef PLATFORM_WEB
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static uint32_t fnv1a(const unsigned char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint64_t alignSection(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+static long fileSizeOf(const char* path) {
+    FILE* file = path ? fopen(path, "rb") : NULL;
+    if (!file) return -1;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+void getMapFilePath(const char* sourcePath, char* out, int outSize) {
+    snprintf(out, outSize, "%s", sourcePath);
+    char* dot = strrchr(out, '.');
+    char* slash = strrchr(out, '/');
+    if (dot && (!slash || dot > slash)) *dot = '\0';
+    strncat(out, MAP_FILE_EXTENSION, outSize - strlen(out) - 1);
+}
+
+bool saveWorldMapFile(const WorldMap* map, const char* filename, const char* sourcePath) {
+    MapFileHeader header = { 0 };
+    memcpy(header.magic, MAP_FILE_MAGIC, 4);
+    header.version = MAP_FILE_VERSION;
+    header.byteOrder = MAP_FILE_BYTE_ORDER;
+    header.countryCount = map->countryCount;
+    header.polygonCount = map->numPolygons;
+    header.pointCount = map->numPoints;
+    header.triangleIndexCount = map->numTriangleIndices;
+
+    long sourceSize = fileSizeOf(sourcePath);
+    header.sourceSize = sourceSize > 0 ? (uint64_t)sourceSize : 0;
+
+    uint64_t offset = sizeof(MapFileHeader);
+    header.countriesOffset = offset = alignSection(offset);
+    offset += (uint64_t)header.countryCount * sizeof(Country);
+    header.polygonsOffset = offset = alignSection(offset);
+    offset += (uint64_t)header.polygonCount * sizeof(Polygon);
+    header.boundsOffset = offset = alignSection(offset);
+    offset += (uint64_t)header.polygonCount * sizeof(PolygonBounds);
+    header.ownersOffset = offset = alignSection(offset);
+    offset += (uint64_t)header.polygonCount * sizeof(int);
+    header.pointsOffset = offset = alignSection(offset);
+    offset += (uint64_t)header.pointCount * sizeof(Vector2);
+    header.trianglesOffset = offset = alignSection(offset);
+    offset += (uint64_t)header.triangleIndexCount * sizeof(int);
+    for (int k = 1; k < MAP_LOD_LEVELS; k++) {
+        MapFileLevel* level = &header.levels[k - 1];
+        level->tolerance = map->levels[k].tolerance;
+        level->pointCount = map->levels[k].numPoints;
+        level->triangleIndexCount = map->levels[k].numTriangleIndices;
+        level->polygonsOffset = offset = alignSection(offset);
+        offset += (uint64_t)header.polygonCount * sizeof(Polygon);
+        level->pointsOffset = offset = alignSection(offset);
+        offset += (uint64_t)level->pointCount * sizeof(Vector2);
+        level->trianglesOffset = offset = alignSection(offset);
+        offset += (uint64_t)level->triangleIndexCount * sizeof(int);
+    }
+    header.fileSize = alignSection(offset);
+
+    unsigned char* data = (unsigned char*)calloc(1, header.fileSize);
+    if (!data) return false;
+
+    memcpy(data + header.countriesOffset, map->countries, header.countryCount * sizeof(Country));
+    memcpy(data + header.polygonsOffset, map->polygons, header.polygonCount * sizeof(Polygon));
+    memcpy(data + header.boundsOffset, map->polygonBounds, header.polygonCount * sizeof(PolygonBounds));
+    memcpy(data + header.ownersOffset, map->polygonCountry, header.polygonCount * sizeof(int));
+    memcpy(data + header.pointsOffset, map->points, header.pointCount * sizeof(Vector2));
+    memcpy(data + header.trianglesOffset, map->triangles, header.triangleIndexCount * sizeof(int));
+    for (int k = 1; k < MAP_LOD_LEVELS; k++) {
+        const MapFileLevel* level = &header.levels[k - 1];
+        memcpy(data + level->polygonsOffset, map->levels[k].polygons, header.polygonCount * sizeof(Polygon));
+        memcpy(data + level->pointsOffset, map->levels[k].points, level->pointCount * sizeof(Vector2));
+        memcpy(data + level->trianglesOffset, map->levels[k].triangles, level->triangleIndexCount * sizeof(int));
+    }
+
+    header.checksum = fnv1a(data + sizeof(MapFileHeader), header.fileSize - sizeof(MapFileHeader));
+    memcpy(data, &header, sizeof(MapFileHeader));
+
+    FILE* file = fopen(filename, "wb");
+    bool ok = file && fwrite(data, 1, header.fileSize, file) == header.fileSize;
+    if (file) fclose(file);
+    free(data);
+
+    if (!ok) printf("Failed to write map file: %s\n", filename);
+    return ok;
+}
+
+static unsigned char* mapFile(const char* filename, size_t* size) {
+#ifndef PLATFORM_WEB
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(MapFileHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    // Private writable mapping: pages are shared with the page cache until
+    // something writes to them, so the loaded map can be modified safely
+    void* data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    *size = st.st_size;
+    return (unsigned char*)data;
+#else
+    int length = 0;
+    unsigned char* data = LoadFileData(filename, &length);
+    if (data && length < (int)sizeof(MapFileHeader)) {
+        UnloadFileData(data);
+        return NULL;
+    }
+    *size = length;
+    return data;
+#endif
+}
+
+static void unmapFile(unsigned char* data, size_t size) {
+#ifndef PLATFORM_WEB
+    munmap(data, size);
+#else
+    (void)size;
+    UnloadFileData(data);
+#endif
+}
+
+static bool validHeader(const MapFileHeader* header, size_t size, const char* sourcePath) {
+    if (memcmp(header->magic, MAP_FILE_MAGIC, 4) != 0) return false;
+    if (header->version != MAP_FILE_VERSION || header->byteOrder != MAP_FILE_BYTE_ORDER) return false;
+    if (header->fileSize != size) return false;
+
+    uint64_t sections[] = {
+        header->countriesOffset + (uint64_t)header->countryCount * sizeof(Country),
+        header->polygonsOffset + (uint64_t)header->polygonCount * sizeof(Polygon),
+        header->boundsOffset + (uint64_t)header->polygonCount * sizeof(PolygonBounds),
+        header->ownersOffset + (uint64_t)header->polygonCount * sizeof(int),
+        header->pointsOffset + (uint64_t)header->pointCount * sizeof(Vector2),
+        header->trianglesOffset + (uint64_t)header->triangleIndexCount * sizeof(int)
+    };
+    for (int i = 0; i < (int)(sizeof(sections) / sizeof(sections[0])); i++) {
+        if (sections[i] > size) return false;
+    }
+    for (int k = 0; k < MAP_LOD_LEVELS - 1; k++) {
+        const MapFileLevel* level = &header->levels[k];
+        if (level->polygonsOffset + (uint64_t)header->polygonCount * sizeof(Polygon) > size ||
+            level->pointsOffset + (uint64_t)level->pointCount * sizeof(Vector2) > size ||
+            level->trianglesOffset + (uint64_t)level->triangleIndexCount * sizeof(int) > size) return false;
+    }
+
+    // A GeoJSON next to the file that changed size means it was edited
+    long sourceSize = fileSizeOf(sourcePath);
+    if (sourceSize >= 0 && (uint64_t)sourceSize != header->sourceSize) return false;
+
+    return true;
+}
+
+// Ranges are trusted by the renderer, so reject anything out of bounds
+static bool validPolygons(const Polygon* polygons, int count, uint64_t pointCount, uint64_t triangleIndexCount) {
+    for (int i = 0; i < count; i++) {
+        const Polygon* poly = &polygons[i];
+        if (poly->pointStart < 0 || poly->numPoints < 0 || poly->triangleStart < 0 || poly->numTriangles < 0 ||
+            (uint64_t)poly->pointStart + poly->numPoints > pointCount ||
+            (uint64_t)poly->triangleStart + poly->numTriangles * 3ull > triangleIndexCount) return false;
+    }
+    return true;
+}
+
+WorldMap* loadWorldMapFile(const char* filename, const char* sourcePath) {
+    size_t size = 0;
+    unsigned char* data = mapFile(filename, &size);
+    if (!data) return NULL;
+
+    const MapFileHeader* header = (const MapFileHeader*)data;
+    // The checksum would touch every page of the mapping, so loading relies
+    // on the header and range checks; verifyWorldMapFile checks the rest
+    if (!validHeader(header, size, sourcePath)) {
+        printf("Ignoring stale or corrupt map file: %s\n", filename);
+        unmapFile(data, size);
+        return NULL;
+    }
+
+    WorldMap* map = (WorldMap*)calloc(1, sizeof(WorldMap));
+    map->zoom = 1.0f;
+    map->mappedFile = data;
+    map->mappedSize = size;
+
+    map->countryCount = header->countryCount;
+    map->numPolygons = header->polygonCount;
+    map->numPoints = header->pointCount;
+    map->numTriangleIndices = header->triangleIndexCount;
+    map->countries = (Country*)(data + header->countriesOffset);
+    map->polygons = (Polygon*)(data + header->polygonsOffset);
+    map->polygonBounds = (PolygonBounds*)(data + header->boundsOffset);
+    map->polygonCountry = (int*)(data + header->ownersOffset);
+    map->points = (Vector2*)(data + header->pointsOffset);
+    map->triangles = (int*)(data + header->trianglesOffset);
+
+    map->levels[0] = (MapLevel){
+        0.0f, map->polygons, map->points, map->numPoints, map->triangles, map->numTriangleIndices
+    };
+    for (int k = 1; k < MAP_LOD_LEVELS; k++) {
+        const MapFileLevel* level = &header->levels[k - 1];
+        map->levels[k] = (MapLevel){
+            level->tolerance,
+            (Polygon*)(data + level->polygonsOffset),
+            (Vector2*)(data + level->pointsOffset), (int)level->pointCount,
+            (int*)(data + level->trianglesOffset), (int)level->triangleIndexCount
+        };
+    }
+
+    bool valid = true;
+    for (int i = 0; i < map->numPolygons && valid; i++) {
+        valid = map->polygonCountry[i] >= 0 && map->polygonCountry[i] < map->countryCount;
+    }
+    for (int k = 0; k < MAP_LOD_LEVELS && valid; k++) {
+        const MapLevel* level = &map->levels[k];
+        valid = validPolygons(level->polygons, map->numPolygons, (uint64_t)level->numPoints, (uint64_t)level->numTriangleIndices);
+    }
+    if (!valid) {
+        printf("Corrupt polygon table in map file: %s\n", filename);
+        free(map);
+        unmapFile(data, size);
+        return NULL;
+    }
+
+    return map;
+}
+
+bool verifyWorldMapFile(const char* filename) {
+    size_t size = 0;
+    unsigned char* data = mapFile(filename, &size);
+    if (!data) return false;
+
+    const MapFileHeader* header = (const MapFileHeader*)data;
+    bool ok = validHeader(header, size, NULL) &&
+              fnv1a(data + sizeof(MapFileHeader), size - sizeof(MapFileHeader)) == header->checksum;
+    unmapFile(data, size);
+    return ok;
+}
+
+void unmapWorldMapFile(WorldMap* map) {
+    if (!map->mappedFile) return;
+    unmapFile((unsigned char*)map->mappedFile, map->mappedSize);
+    map->mappedFile = NULL;
+    map->mappedSize = 0;
+}
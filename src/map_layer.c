@@ -0,0 +1,125 @@
+#include "map_layer.h"
+#include "profiler.h"
+#include "rlgl.h"
+#include <stdlib.h>
+#include <math.h>
+
+static void loadTargets(MapLayer* layer, int width, int height) {
+    for (int i = 0; i < 2; i++) {
+        layer->targets[i] = LoadRenderTexture(width, height);
+    }
+    layer->width = width;
+    layer->height = height;
+    layer->valid = false;
+}
+
+static void unloadTargets(MapLayer* layer) {
+    for (int i = 0; i < 2; i++) {
+        UnloadRenderTexture(layer->targets[i]);
+    }
+}
+
+MapLayer* loadMapLayer(int width, int height) {
+    MapLayer* layer = (MapLayer*)calloc(1, sizeof(MapLayer));
+    if (!layer) return NULL;
+    layer->selectedCountry = -1;
+    loadTargets(layer, width, height);
+    return layer;
+}
+
+void unloadMapLayer(MapLayer* layer) {
+    if (!layer) return;
+    unloadTargets(layer);
+    free(layer);
+}
+
+void invalidateMapLayer(MapLayer* layer) {
+    if (layer) layer->valid = false;
+}
+
+// Draws the part of the map inside `area` (screen pixels) into the bound target
+static void drawMapArea(WorldMap* map, MapMesh* mesh, int selectedCountry, CountryStatusList* statusList, Rectangle area) {
+    BeginScissorMode((int)area.x, (int)area.y, (int)area.width, (int)area.height);
+    if (mesh) {
+        PROF_BEGIN(PROF_FILL);
+        drawMapMesh(mesh, map);
+        PROF_END(PROF_FILL);
+        PROF_BEGIN(PROF_OUTLINE);
+        drawMapMeshOutlines(mesh, map);
+        PROF_END(PROF_OUTLINE);
+    } else {
+        drawWorldMapArea(map, selectedCountry, statusList, area);
+    }
+    EndScissorMode();
+}
+
+// Render textures are stored upside down, hence the negative source height
+static void copyTarget(const RenderTexture2D* source, float x, float y) {
+    Rectangle sourceRec = { 0, 0, (float)source->texture.width, -(float)source->texture.height };
+
+    // Plain copy: blending would darken the layer's transparent edges
+    rlSetBlendFactors(RL_ONE, RL_ZERO, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM);
+    DrawTextureRec(source->texture, sourceRec, (Vector2){ x, y }, WHITE);
+    EndBlendMode();
+}
+
+static bool isWholePixel(float value) {
+    return fabsf(value - roundf(value)) < 0.001f;
+}
+
+void updateMapLayer(MapLayer* layer, WorldMap* map, MapMesh* mesh, int selectedCountry, CountryStatusList* statusList) {
+    if (!layer) return;
+
+    int width = GetScreenWidth();
+    int height = GetScreenHeight();
+    if (width != layer->width || height != layer->height) {
+        unloadTargets(layer);
+        loadTargets(layer, width, height);
+    }
+
+    unsigned int statusVersion = statusList ? statusList->version : 0;
+    bool sameContent = layer->valid && layer->zoom == map->zoom &&
+                       layer->statusVersion == statusVersion &&
+                       layer->selectedCountry == selectedCountry;
+
+    float dx = map->offset.x - layer->offset.x;
+    float dy = map->offset.y - layer->offset.y;
+    if (sameContent && dx == 0.0f && dy == 0.0f) return;
+
+    bool shift = sameContent && isWholePixel(dx) && isWholePixel(dy) &&
+                 fabsf(dx) < width * MAP_LAYER_MAX_SHIFT && fabsf(dy) < height * MAP_LAYER_MAX_SHIFT;
+
+    int next = 1 - layer->current;
+    BeginTextureMode(layer->targets[next]);
+    ClearBackground(BLANK);
+
+    if (shift) {
+        copyTarget(&layer->targets[layer->current], roundf(dx), roundf(dy));
+
+        // Strips uncovered by the shift: one column and one row at most
+        float sx = roundf(dx), sy = roundf(dy);
+        if (sx > 0) drawMapArea(map, mesh, selectedCountry, statusList, (Rectangle){ 0, 0, sx, (float)height });
+        if (sx < 0) drawMapArea(map, mesh, selectedCountry, statusList, (Rectangle){ width + sx, 0, -sx, (float)height });
+        if (sy > 0) drawMapArea(map, mesh, selectedCountry, statusList, (Rectangle){ 0, 0, (float)width, sy });
+        if (sy < 0) drawMapArea(map, mesh, selectedCountry, statusList, (Rectangle){ 0, height + sy, (float)width, -sy });
+    } else {
+        drawMapArea(map, mesh, selectedCountry, statusList, (Rectangle){ 0, 0, (float)width, (float)height });
+    }
+    EndTextureMode();
+
+    layer->current = next;
+    layer->valid = true;
+    layer->offset = map->offset;
+    layer->zoom = map->zoom;
+    layer->statusVersion = statusVersion;
+    layer->selectedCountry = selectedCountry;
+}
+
+void drawMapLayer(const MapLayer* layer) {
+    if (!layer || !layer->valid) return;
+
+    const Texture2D* texture = &layer->targets[layer->current].texture;
+    Rectangle source = { 0, 0, (float)texture->width, -(float)texture->height };
+    DrawTextureRec(*texture, source, (Vector2){ 0, 0 }, WHITE);
+}
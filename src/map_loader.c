@@ -0,0 +1,111 @@
+#include "map_loader.h"
+#include "thread_pool.h"
+#include "platform.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef TT_THREADS
+#include <pthread.h>
+#endif
+
+struct MapLoader {
+    char filename[512];
+    double startTime;       // Startup clock, see platform.h
+
+    // Written by the loading thread under lock
+    const char* stage;
+    float progress;
+    bool done;
+    WorldMap* map;
+    double milliseconds;
+#ifdef TT_THREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    bool threaded;
+#endif
+};
+
+static void lockLoader(MapLoader* loader) {
+#ifdef TT_THREADS
+    pthread_mutex_lock(&loader->lock);
+#else
+    (void)loader;
+#endif
+}
+
+static void unlockLoader(MapLoader* loader) {
+#ifdef TT_THREADS
+    pthread_mutex_unlock(&loader->lock);
+#else
+    (void)loader;
+#endif
+}
+
+// Pickers finish in any order, so progress only moves forward
+static void reportProgress(void* context, const char* stage, float progress) {
+    MapLoader* loader = (MapLoader*)context;
+    lockLoader(loader);
+    if (progress >= loader->progress) {
+        loader->stage = stage;
+        loader->progress = progress;
+    }
+    unlockLoader(loader);
+}
+
+static void runLoad(MapLoader* loader) {
+    WorldMap* map = loadWorldMapWithProgress(loader->filename, reportProgress, loader);
+    double milliseconds = getStartupMilliseconds() - loader->startTime;
+
+    lockLoader(loader);
+    loader->map = map;
+    loader->milliseconds = milliseconds;
+    loader->stage = map ? "Done" : "Failed";
+    loader->progress = 1.0f;
+    loader->done = true;
+    unlockLoader(loader);
+}
+
+#ifdef TT_THREADS
+static void* loaderMain(void* arg) {
+    runLoad((MapLoader*)arg);
+    return NULL;
+}
+#endif
+
+MapLoader* startMapLoad(const char* filename) {
+    MapLoader* loader = (MapLoader*)calloc(1, sizeof(MapLoader));
+    if (!loader) return NULL;
+    snprintf(loader->filename, sizeof(loader->filename), "%s", filename);
+    loader->startTime = getStartupMilliseconds();
+    loader->stage = "Starting";
+
+#ifdef TT_THREADS
+    pthread_mutex_init(&loader->lock, NULL);
+    loader->threaded = pthread_create(&loader->thread, NULL, loaderMain, loader) == 0;
+    if (loader->threaded) return loader;
+#endif
+    runLoad(loader);
+    return loader;
+}
+
+bool pollMapLoad(MapLoader* loader, const char** stage, float* progress) {
+    if (!loader) return true;
+    lockLoader(loader);
+    if (stage) *stage = loader->stage;
+    if (progress) *progress = loader->progress;
+    bool done = loader->done;
+    unlockLoader(loader);
+    return done;
+}
+
+WorldMap* finishMapLoad(MapLoader* loader, double* milliseconds) {
+    if (!loader) return NULL;
+#ifdef TT_THREADS
+    if (loader->threaded) pthread_join(loader->thread, NULL);
+    pthread_mutex_destroy(&loader->lock);
+#endif
+    WorldMap* map = loader->map;
+    if (milliseconds) *milliseconds = loader->milliseconds;
+    free(loader);
+    return map;
+}
@@ -0,0 +1,436 @@
+#include "map_lod.h"
+#include "triangulate.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Polygons per parallel task when marking junctions and simplifying
+#define LOD_POLYGONS_PER_TASK 32
+
+// Which polygons touch a vertex, summarised as a count plus an order
+// independent hash of their indices
+typedef struct {
+    uint64_t key;
+    uint32_t count;
+    uint32_t idHash;
+    int lastPolygon;
+} VertexShare;
+
+typedef struct {
+    VertexShare* slots;
+    uint32_t mask;
+} ShareTable;
+
+static uint64_t pointKey(Vector2 p) {
+    uint32_t x, y;
+    memcpy(&x, &p.x, sizeof(x));
+    memcpy(&y, &p.y, sizeof(y));
+    // +1 keeps the key of (0, 0) away from the empty-slot marker
+    return (((uint64_t)x << 32) | y) + 1;
+}
+
+static uint32_t mixKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static VertexShare* findShare(ShareTable* table, Vector2 p) {
+    uint64_t key = pointKey(p);
+    uint32_t slot = mixKey(key) & table->mask;
+    while (table->slots[slot].key != 0 && table->slots[slot].key != key) {
+        slot = (slot + 1) & table->mask;
+    }
+    VertexShare* share = &table->slots[slot];
+    if (share->key == 0) {
+        share->key = key;
+        share->lastPolygon = -1;
+    }
+    return share;
+}
+
+// Rings are stored closed; the repeated first point is not a vertex of its own
+static int ringVertexCount(const Vector2* points, int numPoints) {
+    if (numPoints > 1 && points[0].x == points[numPoints - 1].x && points[0].y == points[numPoints - 1].y) {
+        return numPoints - 1;
+    }
+    return numPoints;
+}
+
+static bool pointLess(Vector2 a, Vector2 b) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+static float segmentDistanceSq(Vector2 p, Vector2 a, Vector2 b) {
+    float dx = b.x - a.x, dy = b.y - a.y;
+    float lengthSq = dx * dx + dy * dy;
+    float t = 0.0f;
+    if (lengthSq > 0.0f) {
+        t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / lengthSq;
+        if (t < 0.0f) t = 0.0f;
+        else if (t > 1.0f) t = 1.0f;
+    }
+    float ex = a.x + t * dx - p.x, ey = a.y + t * dy - p.y;
+    return ex * ex + ey * ey;
+}
+
+static int farthestFrom(const Vector2* points, int count, int from) {
+    int best = from;
+    float bestDist = -1.0f;
+    for (int j = 0; j < count; j++) {
+        float dx = points[j].x - points[from].x, dy = points[j].y - points[from].y;
+        float dist = dx * dx + dy * dy;
+        if (dist > bestDist) {
+            bestDist = dist;
+            best = j;
+        }
+    }
+    return best;
+}
+
+// Douglas-Peucker over chain[0..count-1], which maps chain positions to
+// ring vertices. Marks the vertices to keep; stack holds 2 * count ints.
+static void simplifyChain(const Vector2* points, const int* chain, int count, float toleranceSq,
+                          unsigned char* keep, int* stack) {
+    keep[chain[0]] = 1;
+    keep[chain[count - 1]] = 1;
+
+    int top = 0;
+    stack[top++] = 0;
+    stack[top++] = count - 1;
+    while (top > 0) {
+        int last = stack[--top];
+        int first = stack[--top];
+        if (last - first < 2) continue;
+
+        Vector2 a = points[chain[first]], b = points[chain[last]];
+        int split = -1;
+        float maxDist = toleranceSq;
+        for (int j = first + 1; j < last; j++) {
+            float dist = segmentDistanceSq(points[chain[j]], a, b);
+            if (dist > maxDist) {
+                maxDist = dist;
+                split = j;
+            }
+        }
+        if (split < 0) continue;
+
+        keep[chain[split]] = 1;
+        stack[top++] = first;
+        stack[top++] = split;
+        stack[top++] = split;
+        stack[top++] = last;
+    }
+}
+
+static const VertexShare* lookupShare(const ShareTable* table, Vector2 p) {
+    uint64_t key = pointKey(p);
+    uint32_t slot = mixKey(key) & table->mask;
+    while (table->slots[slot].key != key) {
+        slot = (slot + 1) & table->mask;
+    }
+    return &table->slots[slot];
+}
+
+// State shared by every task; read-only once the share table is filled
+typedef struct {
+    WorldMap* map;
+    ShareTable shares;
+    unsigned char* locked;  // Per level 0 point: border junction
+    size_t* pointSlots;     // Per polygon, where its simplified ring may go
+    size_t* triangleSlots;
+    int blockCount;
+    struct LodScratch* scratch;  // One per pool thread
+} LodBuild;
+
+// Per-thread work space, sized for the largest ring
+typedef struct LodScratch {
+    unsigned char* keep;
+    int* nodes;
+    int* chain;
+    int* stack;
+    int* triangulateScratch;
+} LodScratch;
+
+static bool fillShareTable(LodBuild* build) {
+    const WorldMap* map = build->map;
+    uint32_t capacity = 16;
+    while (capacity < (uint32_t)map->numPoints * 2u) capacity *= 2;
+    build->shares.slots = (VertexShare*)calloc(capacity, sizeof(VertexShare));
+    build->shares.mask = capacity - 1;
+    build->locked = (unsigned char*)calloc(map->numPoints > 0 ? map->numPoints : 1, 1);
+    if (!build->shares.slots || !build->locked) return false;
+
+    for (int i = 0; i < map->numPolygons; i++) {
+        const Vector2* points = getPolygonPoints(map, i);
+        int count = ringVertexCount(points, map->polygons[i].numPoints);
+        for (int j = 0; j < count; j++) {
+            VertexShare* share = findShare(&build->shares, points[j]);
+            if (share->lastPolygon == i) continue;
+            share->lastPolygon = i;
+            share->count++;
+            share->idHash += mixKey((uint64_t)i + 1);
+        }
+    }
+    return true;
+}
+
+// A vertex whose polygon set differs from a neighbour's ends a border
+static void markJunctionsTask(void* context, int block, int worker) {
+    (void)worker;
+    LodBuild* build = (LodBuild*)context;
+    const WorldMap* map = build->map;
+    int end = (block + 1) * LOD_POLYGONS_PER_TASK;
+    if (end > map->numPolygons) end = map->numPolygons;
+
+    for (int i = block * LOD_POLYGONS_PER_TASK; i < end; i++) {
+        const Polygon* poly = &map->polygons[i];
+        const Vector2* points = getPolygonPoints(map, i);
+        int count = ringVertexCount(points, poly->numPoints);
+        for (int j = 0; j < count; j++) {
+            const VertexShare* here = lookupShare(&build->shares, points[j]);
+            const VertexShare* prev = lookupShare(&build->shares, points[(j + count - 1) % count]);
+            const VertexShare* next = lookupShare(&build->shares, points[(j + 1) % count]);
+            if (here->count != prev->count || here->idHash != prev->idHash ||
+                here->count != next->count || here->idHash != next->idHash) {
+                build->locked[poly->pointStart + j] = 1;
+            }
+        }
+    }
+}
+
+// Keeps the extreme points when a small island collapses below a triangle
+static void keepExtremes(const Vector2* points, int count, unsigned char* keep) {
+    int minX = 0, maxX = 0, minY = 0, maxY = 0;
+    for (int j = 1; j < count; j++) {
+        if (points[j].x < points[minX].x) minX = j;
+        if (points[j].x > points[maxX].x) maxX = j;
+        if (points[j].y < points[minY].y) minY = j;
+        if (points[j].y > points[maxY].y) maxY = j;
+    }
+    keep[minX] = keep[maxX] = keep[minY] = keep[maxY] = 1;
+}
+
+// Simplifies one ring into out (closed again) and returns its point count
+static int simplifyRing(const Vector2* points, int numPoints, const unsigned char* locked, float tolerance,
+                        LodScratch* scratch, Vector2* out) {
+    int count = ringVertexCount(points, numPoints);
+    if (count <= 3) {
+        memcpy(out, points, numPoints * sizeof(Vector2));
+        return numPoints;
+    }
+
+    int* nodes = scratch->nodes;
+    int nodeCount = 0;
+    for (int j = 0; j < count; j++) {
+        if (locked[j]) nodes[nodeCount++] = j;
+    }
+
+    // Rings with no junctions (islands) are anchored at their lowest point
+    // and the vertex farthest from it, which both sides agree on
+    if (nodeCount == 0) {
+        int anchor = 0;
+        for (int j = 1; j < count; j++) {
+            if (pointLess(points[j], points[anchor])) anchor = j;
+        }
+        nodes[nodeCount++] = anchor;
+    }
+    if (nodeCount == 1) {
+        int far = farthestFrom(points, count, nodes[0]);
+        if (far != nodes[0]) {
+            if (far > nodes[0]) nodes[nodeCount++] = far;
+            else {
+                nodes[1] = nodes[0];
+                nodes[0] = far;
+                nodeCount = 2;
+            }
+        }
+    }
+
+    unsigned char* keep = scratch->keep;
+    memset(keep, 0, count);
+    float toleranceSq = tolerance * tolerance;
+
+    for (int n = 0; n < nodeCount; n++) {
+        int start = nodes[n];
+        int end = nodes[(n + 1) % nodeCount];
+        int length = (end - start + count) % count + 1;
+        if (nodeCount == 1) length = count + 1;
+        if (length <= 2) {
+            keep[start] = keep[end] = 1;
+            continue;
+        }
+
+        // Walk shared borders in the same direction from both polygons
+        bool reverse = pointLess(points[end], points[start]);
+        for (int c = 0; c < length; c++) {
+            int offset = reverse ? length - 1 - c : c;
+            scratch->chain[c] = (start + offset) % count;
+        }
+        simplifyChain(points, scratch->chain, length, toleranceSq, keep, scratch->stack);
+    }
+
+    int kept = 0;
+    for (int j = 0; j < count; j++) kept += keep[j];
+    if (kept < 3) keepExtremes(points, count, keep);
+
+    int outCount = 0;
+    for (int j = 0; j < count; j++) {
+        if (keep[j]) out[outCount++] = points[j];
+    }
+    if (outCount < 3) {
+        memcpy(out, points, numPoints * sizeof(Vector2));
+        return numPoints;
+    }
+    out[outCount++] = out[0];
+    return outCount;
+}
+
+// Simplifies one block of polygons of one level into their slots
+static void simplifyTask(void* context, int index, int worker) {
+    LodBuild* build = (LodBuild*)context;
+    WorldMap* map = build->map;
+    MapLevel* level = &map->levels[1 + index / build->blockCount];
+    LodScratch* scratch = &build->scratch[worker];
+    int block = index % build->blockCount;
+    int end = (block + 1) * LOD_POLYGONS_PER_TASK;
+    if (end > map->numPolygons) end = map->numPolygons;
+
+    for (int i = block * LOD_POLYGONS_PER_TASK; i < end; i++) {
+        const Polygon* source = &map->polygons[i];
+        Polygon* poly = &level->polygons[i];
+        poly->pointStart = (int)build->pointSlots[i];
+        poly->numPoints = simplifyRing(getPolygonPoints(map, i), source->numPoints,
+                                       build->locked + source->pointStart, level->tolerance,
+                                       scratch, level->points + poly->pointStart);
+        poly->triangleStart = (int)build->triangleSlots[i];
+        poly->numTriangles = 0;
+        if (poly->numPoints >= 3) {
+            poly->numTriangles = triangulatePolygon(level->points + poly->pointStart, poly->numPoints,
+                                                    level->triangles + poly->triangleStart,
+                                                    scratch->triangulateScratch);
+        }
+    }
+}
+
+// Closes the gaps between slots once every polygon of a level is done. Rings
+// only move towards the front, so this works in place.
+static void compactLevel(const WorldMap* map, MapLevel* level) {
+    level->numPoints = 0;
+    level->numTriangleIndices = 0;
+    for (int i = 0; i < map->numPolygons; i++) {
+        Polygon* poly = &level->polygons[i];
+        memmove(level->points + level->numPoints, level->points + poly->pointStart, poly->numPoints * sizeof(Vector2));
+        memmove(level->triangles + level->numTriangleIndices, level->triangles + poly->triangleStart,
+                poly->numTriangles * 3 * sizeof(int));
+        poly->pointStart = level->numPoints;
+        poly->triangleStart = level->numTriangleIndices;
+        level->numPoints += poly->numPoints;
+        level->numTriangleIndices += poly->numTriangles * 3;
+    }
+
+    Vector2* points = (Vector2*)realloc(level->points, (level->numPoints > 0 ? level->numPoints : 1) * sizeof(Vector2));
+    if (points) level->points = points;
+    int* triangles = (int*)realloc(level->triangles, (level->numTriangleIndices > 0 ? level->numTriangleIndices : 1) * sizeof(int));
+    if (triangles) level->triangles = triangles;
+}
+
+bool buildMapLevels(WorldMap* map, ThreadPool* pool) {
+    static const float tolerances[MAP_LOD_LEVELS] = MAP_LOD_TOLERANCES;
+
+    map->levels[0] = (MapLevel){
+        tolerances[0], map->polygons, map->points, map->numPoints, map->triangles, map->numTriangleIndices
+    };
+
+    LodBuild build = { 0 };
+    build.map = map;
+    build.blockCount = (map->numPolygons + LOD_POLYGONS_PER_TASK - 1) / LOD_POLYGONS_PER_TASK;
+    bool ok = fillShareTable(&build);
+
+    // Simplified rings never have more vertices than the source (plus a
+    // closing point), so each polygon gets a slot of that size up front and
+    // all of them can be simplified at once
+    build.pointSlots = (size_t*)malloc((map->numPolygons + 1) * sizeof(size_t));
+    build.triangleSlots = (size_t*)malloc((map->numPolygons + 1) * sizeof(size_t));
+    ok = ok && build.pointSlots && build.triangleSlots;
+
+    int maxPoints = 1;
+    if (ok) {
+        build.pointSlots[0] = build.triangleSlots[0] = 0;
+        for (int i = 0; i < map->numPolygons; i++) {
+            int numPoints = map->polygons[i].numPoints;
+            int count = ringVertexCount(getPolygonPoints(map, i), numPoints);
+            build.pointSlots[i + 1] = build.pointSlots[i] + numPoints + 1;
+            build.triangleSlots[i + 1] = build.triangleSlots[i] + (count > 2 ? 3 * (size_t)(count - 2) : 0);
+            if (numPoints > maxPoints) maxPoints = numPoints;
+        }
+    }
+
+    int threadCount = getThreadPoolSize(pool);
+    build.scratch = (LodScratch*)calloc(threadCount, sizeof(LodScratch));
+    ok = ok && build.scratch;
+    for (int t = 0; ok && t < threadCount; t++) {
+        LodScratch* scratch = &build.scratch[t];
+        scratch->keep = (unsigned char*)malloc(maxPoints);
+        scratch->nodes = (int*)malloc(maxPoints * sizeof(int));
+        scratch->chain = (int*)malloc((maxPoints + 1) * sizeof(int));
+        scratch->stack = (int*)malloc(2 * (maxPoints + 1) * sizeof(int));
+        scratch->triangulateScratch = (int*)malloc(2 * maxPoints * sizeof(int));
+        ok = scratch->keep && scratch->nodes && scratch->chain && scratch->stack && scratch->triangulateScratch;
+    }
+
+    for (int k = 1; k < MAP_LOD_LEVELS && ok; k++) {
+        MapLevel* level = &map->levels[k];
+        level->tolerance = tolerances[k];
+        level->polygons = (Polygon*)malloc((map->numPolygons > 0 ? map->numPolygons : 1) * sizeof(Polygon));
+        level->points = (Vector2*)malloc((build.pointSlots[map->numPolygons] + 1) * sizeof(Vector2));
+        level->triangles = (int*)malloc((build.triangleSlots[map->numPolygons] + 1) * sizeof(int));
+        ok = level->polygons && level->points && level->triangles;
+    }
+
+    if (ok) {
+        parallelFor(pool, build.blockCount, markJunctionsTask, &build);
+        parallelFor(pool, (MAP_LOD_LEVELS - 1) * build.blockCount, simplifyTask, &build);
+        for (int k = 1; k < MAP_LOD_LEVELS; k++) {
+            compactLevel(map, &map->levels[k]);
+        }
+    }
+
+    for (int t = 0; build.scratch && t < threadCount; t++) {
+        free(build.scratch[t].keep);
+        free(build.scratch[t].nodes);
+        free(build.scratch[t].chain);
+        free(build.scratch[t].stack);
+        free(build.scratch[t].triangulateScratch);
+    }
+    free(build.scratch);
+    free(build.shares.slots);
+    free(build.locked);
+    free(build.pointSlots);
+    free(build.triangleSlots);
+
+    if (!ok) freeMapLevels(map);
+    return ok;
+}
+
+void freeMapLevels(WorldMap* map) {
+    for (int k = 1; k < MAP_LOD_LEVELS; k++) {
+        free(map->levels[k].polygons);
+        free(map->levels[k].points);
+        free(map->levels[k].triangles);
+        memset(&map->levels[k], 0, sizeof(MapLevel));
+    }
+}
+
+int selectMapLevel(const WorldMap* map, float zoom) {
+    return selectMapLevelForScale(map, 360.0f / (SCREEN_WIDTH * zoom));
+}
+
+int selectMapLevelForScale(const WorldMap* map, float degreesPerPixel) {
+    int level = 0;
+    for (int k = 1; k < MAP_LOD_LEVELS; k++) {
+        if (map->levels[k].polygons && map->levels[k].tolerance <= degreesPerPixel) level = k;
+    }
+    return level;
+}
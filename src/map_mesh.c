@@ -0,0 +1,423 @@
+#include "map_mesh.h"
+#include "map_lod.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    float* vertices;
+    float* texcoords;
+    unsigned short* indices;
+    int vertexCount;
+    int triangleCount;
+} MeshBuilder;
+
+static void beginChunk(MeshBuilder* b) {
+    b->vertices = (float*)MemAlloc(MAP_MESH_MAX_VERTICES * 3 * sizeof(float));
+    b->texcoords = (float*)MemAlloc(MAP_MESH_MAX_VERTICES * 2 * sizeof(float));
+    b->indices = (unsigned short*)MemAlloc(MAP_MESH_MAX_VERTICES * 3 * sizeof(unsigned short));
+    b->vertexCount = 0;
+    b->triangleCount = 0;
+}
+
+static void endChunk(MeshBuilder* b, MapMesh* mesh) {
+    if (b->triangleCount == 0) {
+        MemFree(b->vertices);
+        MemFree(b->texcoords);
+        MemFree(b->indices);
+        return;
+    }
+
+    Mesh chunk = { 0 };
+    chunk.vertexCount = b->vertexCount;
+    chunk.triangleCount = b->triangleCount;
+    chunk.vertices = b->vertices;
+    chunk.texcoords = b->texcoords;
+    chunk.indices = b->indices;
+    UploadMesh(&chunk, false);
+
+    mesh->meshes[mesh->meshCount++] = chunk;
+}
+
+static void addVertex(MeshBuilder* b, Vector2 point, float u) {
+    b->vertices[b->vertexCount * 3 + 0] = point.x;
+    b->vertices[b->vertexCount * 3 + 1] = point.y;
+    b->vertices[b->vertexCount * 3 + 2] = 0.0f;
+    b->texcoords[b->vertexCount * 2 + 0] = u;
+    b->texcoords[b->vertexCount * 2 + 1] = 0.5f;
+    b->vertexCount++;
+}
+
+static void addTriangle(MeshBuilder* b, int i0, int i1, int i2) {
+    b->indices[b->triangleCount * 3 + 0] = (unsigned short)i0;
+    b->indices[b->triangleCount * 3 + 1] = (unsigned short)i1;
+    b->indices[b->triangleCount * 3 + 2] = (unsigned short)i2;
+    b->triangleCount++;
+}
+
+static void addLevelChunks(MapMesh* mesh, const WorldMap* map, const MapLevel* level) {
+    MeshBuilder builder;
+    beginChunk(&builder);
+
+    for (int i = 0; i < map->numPolygons; i++) {
+        const Polygon* poly = &level->polygons[i];
+        const Vector2* points = getLevelPoints(level, i);
+        const int* triangles = getLevelTriangles(level, i);
+        float u = (map->polygonCountry[i] + 0.5f) / map->countryCount;
+        if (poly->numTriangles == 0) continue;
+
+        if (poly->numPoints <= MAP_MESH_MAX_VERTICES) {
+            // Shared vertices, polygon kept whole inside one chunk
+            if (builder.vertexCount + poly->numPoints > MAP_MESH_MAX_VERTICES) {
+                endChunk(&builder, mesh);
+                beginChunk(&builder);
+            }
+
+            int base = builder.vertexCount;
+            for (int j = 0; j < poly->numPoints; j++) {
+                addVertex(&builder, points[j], u);
+            }
+            for (int t = 0; t < poly->numTriangles; t++) {
+                const int* tri = &triangles[t * 3];
+                addTriangle(&builder, base + tri[0], base + tri[1], base + tri[2]);
+            }
+        } else {
+            // Too many points for 16-bit indices: emit unshared triangles
+            for (int t = 0; t < poly->numTriangles; t++) {
+                if (builder.vertexCount + 3 > MAP_MESH_MAX_VERTICES) {
+                    endChunk(&builder, mesh);
+                    beginChunk(&builder);
+                }
+
+                const int* tri = &triangles[t * 3];
+                int base = builder.vertexCount;
+                addVertex(&builder, points[tri[0]], u);
+                addVertex(&builder, points[tri[1]], u);
+                addVertex(&builder, points[tri[2]], u);
+                addTriangle(&builder, base, base + 1, base + 2);
+            }
+        }
+    }
+    endChunk(&builder, mesh);
+}
+
+// Outline quads: every vertex carries its own end of the edge in
+// vertexPosition and the other end plus a side (+1 or -1) in vertexNormal
+#define OUTLINE_EDGES_PER_CHUNK (MAP_MESH_MAX_VERTICES / 4)
+
+typedef struct {
+    Vector2 a;
+    Vector2 b;
+} MapEdge;
+
+static bool pointBefore(Vector2 p, Vector2 q) {
+    return p.x < q.x || (p.x == q.x && p.y < q.y);
+}
+
+static uint32_t hashEdge(const MapEdge* edge) {
+    uint32_t words[4];
+    memcpy(words, edge, sizeof(words));
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < 4; i++) {
+        hash = (hash ^ words[i]) * 16777619u;
+        hash ^= hash >> 15;
+    }
+    return hash;
+}
+
+// Ring edges of the level (of one country when country >= 0). Both sides of
+// a shared border produce the same edge, which is kept only once.
+static int collectEdges(const WorldMap* map, const MapLevel* level, int country, MapEdge** out) {
+    int maxEdges = 0;
+    for (int i = 0; i < map->numPolygons; i++) {
+        if (country < 0 || map->polygonCountry[i] == country) maxEdges += level->polygons[i].numPoints;
+    }
+    *out = NULL;
+    if (maxEdges == 0) return 0;
+
+    int tableSize = 1;
+    while (tableSize < maxEdges * 2) tableSize <<= 1;
+    MapEdge* edges = (MapEdge*)malloc(sizeof(MapEdge) * maxEdges);
+    int* table = (int*)malloc(sizeof(int) * tableSize);
+    if (!edges || !table) {
+        free(edges);
+        free(table);
+        return 0;
+    }
+    memset(table, 0xff, sizeof(int) * tableSize);
+
+    int count = 0;
+    for (int i = 0; i < map->numPolygons; i++) {
+        if (country >= 0 && map->polygonCountry[i] != country) continue;
+        const Polygon* poly = &level->polygons[i];
+        const Vector2* points = getLevelPoints(level, i);
+
+        for (int j = 0; j < poly->numPoints; j++) {
+            Vector2 p = points[j];
+            Vector2 q = points[(j + 1) % poly->numPoints];
+            if (p.x == q.x && p.y == q.y) continue;
+
+            MapEdge edge = pointBefore(p, q) ? (MapEdge){ p, q } : (MapEdge){ q, p };
+            uint32_t slot = hashEdge(&edge) & (tableSize - 1);
+            bool seen = false;
+            while (table[slot] >= 0) {
+                const MapEdge* other = &edges[table[slot]];
+                if (other->a.x == edge.a.x && other->a.y == edge.a.y &&
+                    other->b.x == edge.b.x && other->b.y == edge.b.y) {
+                    seen = true;
+                    break;
+                }
+                slot = (slot + 1) & (tableSize - 1);
+            }
+            if (seen) continue;
+
+            table[slot] = count;
+            edges[count++] = edge;
+        }
+    }
+
+    free(table);
+    *out = edges;
+    return count;
+}
+
+static void setOutlineVertex(Mesh* chunk, int vertex, Vector2 point, Vector2 other, float side) {
+    chunk->vertices[vertex * 3 + 0] = point.x;
+    chunk->vertices[vertex * 3 + 1] = point.y;
+    chunk->vertices[vertex * 3 + 2] = 0.0f;
+    chunk->normals[vertex * 3 + 0] = other.x;
+    chunk->normals[vertex * 3 + 1] = other.y;
+    chunk->normals[vertex * 3 + 2] = side;
+}
+
+static int outlineChunkCount(int edgeCount) {
+    return (edgeCount + OUTLINE_EDGES_PER_CHUNK - 1) / OUTLINE_EDGES_PER_CHUNK;
+}
+
+static void addOutlineChunks(Mesh* meshes, int* meshCount, const MapEdge* edges, int edgeCount) {
+    for (int start = 0; start < edgeCount; start += OUTLINE_EDGES_PER_CHUNK) {
+        int count = edgeCount - start;
+        if (count > OUTLINE_EDGES_PER_CHUNK) count = OUTLINE_EDGES_PER_CHUNK;
+
+        Mesh chunk = { 0 };
+        chunk.vertexCount = count * 4;
+        chunk.triangleCount = count * 2;
+        chunk.vertices = (float*)MemAlloc(chunk.vertexCount * 3 * sizeof(float));
+        chunk.normals = (float*)MemAlloc(chunk.vertexCount * 3 * sizeof(float));
+        chunk.indices = (unsigned short*)MemAlloc(chunk.triangleCount * 3 * sizeof(unsigned short));
+
+        for (int e = 0; e < count; e++) {
+            const MapEdge* edge = &edges[start + e];
+            int base = e * 4;
+
+            // The normal flips with the direction, so the far end takes the
+            // opposite sides to land on the same edges of the quad
+            setOutlineVertex(&chunk, base + 0, edge->a, edge->b, 1.0f);
+            setOutlineVertex(&chunk, base + 1, edge->a, edge->b, -1.0f);
+            setOutlineVertex(&chunk, base + 2, edge->b, edge->a, -1.0f);
+            setOutlineVertex(&chunk, base + 3, edge->b, edge->a, 1.0f);
+
+            unsigned short* quad = &chunk.indices[e * 6];
+            quad[0] = (unsigned short)(base + 0);
+            quad[1] = (unsigned short)(base + 1);
+            quad[2] = (unsigned short)(base + 3);
+            quad[3] = (unsigned short)(base + 0);
+            quad[4] = (unsigned short)(base + 3);
+            quad[5] = (unsigned short)(base + 2);
+        }
+
+        UploadMesh(&chunk, false);
+        meshes[(*meshCount)++] = chunk;
+    }
+}
+
+// Builds the outline chunks of every level into a fresh array
+static Mesh* buildOutlineLevels(const WorldMap* map, int country, int* meshCount, int levelStart[MAP_LOD_LEVELS + 1]) {
+    MapEdge* edges[MAP_LOD_LEVELS];
+    int edgeCounts[MAP_LOD_LEVELS];
+    int maxChunks = 0;
+    for (int k = 0; k < MAP_LOD_LEVELS; k++) {
+        edgeCounts[k] = collectEdges(map, &map->levels[k], country, &edges[k]);
+        maxChunks += outlineChunkCount(edgeCounts[k]);
+    }
+
+    Mesh* meshes = (Mesh*)calloc(maxChunks > 0 ? maxChunks : 1, sizeof(Mesh));
+    *meshCount = 0;
+    for (int k = 0; k < MAP_LOD_LEVELS; k++) {
+        levelStart[k] = *meshCount;
+        if (meshes) addOutlineChunks(meshes, meshCount, edges[k], edgeCounts[k]);
+        free(edges[k]);
+    }
+    levelStart[MAP_LOD_LEVELS] = *meshCount;
+    return meshes;
+}
+
+static void unloadMeshes(Mesh* meshes, int count) {
+    for (int i = 0; i < count; i++) {
+        UnloadMesh(meshes[i]);
+    }
+    free(meshes);
+}
+
+static void setCameraUniforms(Shader shader, int zoomLoc, int offsetLoc, int screenSizeLoc, const WorldMap* map) {
+    Vector2 screenSize = { (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+    SetShaderValue(shader, zoomLoc, &map->zoom, SHADER_UNIFORM_FLOAT);
+    SetShaderValue(shader, offsetLoc, &map->offset, SHADER_UNIFORM_VEC2);
+    SetShaderValue(shader, screenSizeLoc, &screenSize, SHADER_UNIFORM_VEC2);
+}
+
+MapMesh* loadMapMesh(const WorldMap* map) {
+    if (!map || map->countryCount == 0) return NULL;
+
+    Shader shader = LoadShader("shaders/map.vs", "shaders/map.fs");
+    if (shader.id == 0) {
+        printf("ERROR: Map shader failed to compile!\n");
+        return NULL;
+    }
+    Shader outlineShader = LoadShader("shaders/outline.vs", "shaders/outline.fs");
+    if (outlineShader.id == 0) {
+        printf("ERROR: Outline shader failed to compile!\n");
+        UnloadShader(shader);
+        return NULL;
+    }
+
+    MapMesh* mesh = (MapMesh*)calloc(1, sizeof(MapMesh));
+    mesh->countryCount = map->countryCount;
+    mesh->zoomLoc = GetShaderLocation(shader, "zoom");
+    mesh->offsetLoc = GetShaderLocation(shader, "offset");
+    mesh->screenSizeLoc = GetShaderLocation(shader, "screenSize");
+
+    // Upper bound: every polygon either fits a chunk or is split per triangle
+    int maxChunks = 0;
+    for (int k = 0; k < MAP_LOD_LEVELS; k++) {
+        const MapLevel* level = &map->levels[k];
+        int totalVertices = 0;
+        for (int i = 0; i < map->numPolygons; i++) {
+            totalVertices += level->polygons[i].numPoints + 3 * level->polygons[i].numTriangles;
+        }
+        maxChunks += totalVertices / MAP_MESH_MAX_VERTICES + map->numPolygons + 1;
+    }
+    mesh->meshes = (Mesh*)calloc(maxChunks, sizeof(Mesh));
+
+    // Every level gets its own run of chunks so drawing one never touches
+    // the vertices of another
+    for (int k = 0; k < MAP_LOD_LEVELS; k++) {
+        mesh->levelStart[k] = mesh->meshCount;
+        addLevelChunks(mesh, map, &map->levels[k]);
+    }
+    mesh->levelStart[MAP_LOD_LEVELS] = mesh->meshCount;
+
+    // Per-country color lookup, sampled with point filtering
+    mesh->colors = (Color*)calloc(map->countryCount, sizeof(Color));
+    for (int c = 0; c < map->countryCount; c++) {
+        mesh->colors[c] = DEFAULT_LAND_COLOR;
+    }
+    Image colorImage = {
+        .data = mesh->colors,
+        .width = map->countryCount,
+        .height = 1,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+    mesh->colorTexture = LoadTextureFromImage(colorImage);
+    SetTextureFilter(mesh->colorTexture, TEXTURE_FILTER_POINT);
+
+    mesh->material = LoadMaterialDefault();
+    mesh->material.shader = shader;
+    mesh->material.maps[MATERIAL_MAP_DIFFUSE].texture = mesh->colorTexture;
+
+    mesh->outlineMeshes = buildOutlineLevels(map, -1, &mesh->outlineMeshCount, mesh->outlineLevelStart);
+    mesh->outlineMaterial = LoadMaterialDefault();
+    mesh->outlineMaterial.shader = outlineShader;
+    mesh->outlineZoomLoc = GetShaderLocation(outlineShader, "zoom");
+    mesh->outlineOffsetLoc = GetShaderLocation(outlineShader, "offset");
+    mesh->outlineScreenSizeLoc = GetShaderLocation(outlineShader, "screenSize");
+    mesh->outlineHalfWidthLoc = GetShaderLocation(outlineShader, "halfWidth");
+    mesh->selectedCountry = -1;
+
+    return mesh;
+}
+
+void unloadMapMesh(MapMesh* mesh) {
+    if (!mesh) return;
+
+    unloadMeshes(mesh->meshes, mesh->meshCount);
+    unloadMeshes(mesh->outlineMeshes, mesh->outlineMeshCount);
+    unloadMeshes(mesh->selectionMeshes, mesh->selectionMeshCount);
+    UnloadMaterial(mesh->material);     // Also releases the shader and color texture
+    UnloadMaterial(mesh->outlineMaterial);
+    free(mesh->colors);
+    free(mesh);
+}
+
+void updateMapMeshColor(MapMesh* mesh, int countryIndex, Color color) {
+    if (!mesh || countryIndex < 0 || countryIndex >= mesh->countryCount) return;
+
+    mesh->colors[countryIndex] = color;
+    UpdateTextureRec(mesh->colorTexture, (Rectangle){ (float)countryIndex, 0, 1, 1 }, &mesh->colors[countryIndex]);
+}
+
+void syncMapMeshColors(MapMesh* mesh, const WorldMap* map, int selectedCountry, CountryStatusList* statusList) {
+    if (!mesh) return;
+
+    int selectedIndex = selectedCountry >= 0 && selectedCountry < mesh->countryCount ? selectedCountry : -1;
+    for (int c = 0; c < mesh->countryCount; c++) {
+        int status = GetCountryStatusByKey(statusList, map->countries[c].isoKey);
+        mesh->colors[c] = getCountryColor(status, c == selectedIndex);
+    }
+    UpdateTexture(mesh->colorTexture, mesh->colors);
+
+    if (selectedIndex != mesh->selectedCountry) {
+        unloadMeshes(mesh->selectionMeshes, mesh->selectionMeshCount);
+        mesh->selectionMeshes = NULL;
+        mesh->selectionMeshCount = 0;
+        memset(mesh->selectionLevelStart, 0, sizeof(mesh->selectionLevelStart));
+        if (selectedIndex >= 0) {
+            mesh->selectionMeshes = buildOutlineLevels(map, selectedIndex, &mesh->selectionMeshCount, mesh->selectionLevelStart);
+        }
+        mesh->selectedCountry = selectedIndex;
+    }
+}
+
+void drawMapMesh(MapMesh* mesh, const WorldMap* map) {
+    if (!mesh) return;
+
+    setCameraUniforms(mesh->material.shader, mesh->zoomLoc, mesh->offsetLoc, mesh->screenSizeLoc, map);
+
+    // Ring winding is not normalised, so triangles may face either way
+    rlDisableBackfaceCulling();
+    int level = selectMapLevel(map, map->zoom);
+    for (int i = mesh->levelStart[level]; i < mesh->levelStart[level + 1]; i++) {
+        DrawMesh(mesh->meshes[i], mesh->material, MatrixIdentity());
+    }
+    rlEnableBackfaceCulling();
+}
+
+static void drawOutlineChunks(MapMesh* mesh, const Mesh* meshes, int start, int end, float width, Color color) {
+    float halfWidth = width * 0.5f;
+    SetShaderValue(mesh->outlineMaterial.shader, mesh->outlineHalfWidthLoc, &halfWidth, SHADER_UNIFORM_FLOAT);
+    mesh->outlineMaterial.maps[MATERIAL_MAP_DIFFUSE].color = color;
+    for (int i = start; i < end; i++) {
+        DrawMesh(meshes[i], mesh->outlineMaterial, MatrixIdentity());
+    }
+}
+
+void drawMapMeshOutlines(MapMesh* mesh, const WorldMap* map) {
+    if (!mesh) return;
+
+    setCameraUniforms(mesh->outlineMaterial.shader, mesh->outlineZoomLoc, mesh->outlineOffsetLoc,
+                      mesh->outlineScreenSizeLoc, map);
+
+    rlDisableBackfaceCulling();
+    int level = selectMapLevel(map, map->zoom);
+    drawOutlineChunks(mesh, mesh->outlineMeshes, mesh->outlineLevelStart[level],
+                      mesh->outlineLevelStart[level + 1], MAP_OUTLINE_WIDTH, BLACK);
+    if (mesh->selectionMeshes) {
+        drawOutlineChunks(mesh, mesh->selectionMeshes, mesh->selectionLevelStart[level],
+                          mesh->selectionLevelStart[level + 1], MAP_SELECTED_OUTLINE_WIDTH, SELECTED_OUTLINE_COLOR);
+    }
+    rlEnableBackfaceCulling();
+}
@@ -0,0 +1,495 @@
+#include "map_tiles.h"
+#include "raster.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef TT_THREADS
+#include <pthread.h>
+#endif
+
+#define MAP_TILE_BUCKETS 1024
+#define MAP_TILE_MAX_REQUESTS 512
+
+typedef struct {
+    int z, x, y;
+} TileKey;
+
+typedef struct {
+    TileKey key;
+    Texture2D texture;
+    unsigned int generation;    // Status generation the texture shows
+    unsigned int lastUsed;      // Frame it was last needed for the view
+    int next;                   // Hash chain, -1 ends it
+} TileEntry;
+
+typedef struct {
+    TileKey key;
+    unsigned int generation;
+    Image image;
+} TileResult;
+
+typedef struct {
+    TileKey key;
+    int distance;
+} TileRequest;
+
+// A renderer with its own raster context and status copy; the map is only read
+typedef struct {
+    MapTiles* tiles;
+    RasterContext* context;
+    CountryStatusList statuses;     // Only statusByKey is filled in
+    unsigned int generation;
+    TileKey busy;
+    bool isBusy;
+#ifdef TT_THREADS
+    pthread_t thread;
+#endif
+} TileWorker;
+
+struct MapTiles {
+    // Cache, main thread only
+    TileEntry* entries;
+    int entryCount;
+    int entryCapacity;              // Tiles that fit the budget
+    int buckets[MAP_TILE_BUCKETS];
+    unsigned int frame;
+    unsigned int statusVersion;
+    bool hasStatuses;
+
+    // View of the last update
+    bool active;
+    int level;
+    int x0, y0, x1, y1;             // Inclusive tile range, empty when x0 > x1
+
+    // Shared with the workers under lock
+    unsigned char statusByKey[ISO_KEY_COUNT];
+    unsigned int generation;        // Bumped whenever the statuses change
+    TileKey requests[MAP_TILE_MAX_REQUESTS];
+    int requestHead;
+    int requestCount;
+    TileResult* results;            // Rendered, waiting for upload
+    int resultCount;
+    int resultCapacity;
+    TileWorker workers[MAP_TILE_WORKERS];
+    int workerCount;
+#ifdef TT_THREADS
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stopping;
+#endif
+};
+
+static void lockTiles(MapTiles* tiles) {
+#ifdef TT_THREADS
+    pthread_mutex_lock(&tiles->lock);
+#else
+    (void)tiles;
+#endif
+}
+
+static void unlockTiles(MapTiles* tiles) {
+#ifdef TT_THREADS
+    pthread_mutex_unlock(&tiles->lock);
+#else
+    (void)tiles;
+#endif
+}
+
+static bool sameKey(TileKey a, TileKey b) {
+    return a.z == b.z && a.x == b.x && a.y == b.y;
+}
+
+static unsigned int hashKey(TileKey key) {
+    return ((unsigned int)key.z * 73856093u ^ (unsigned int)key.x * 19349663u ^
+            (unsigned int)key.y * 83492791u) % MAP_TILE_BUCKETS;
+}
+
+static int findEntry(const MapTiles* tiles, TileKey key) {
+    for (int i = tiles->buckets[hashKey(key)]; i >= 0; i = tiles->entries[i].next) {
+        if (sameKey(tiles->entries[i].key, key)) return i;
+    }
+    return -1;
+}
+
+static void unlinkEntry(MapTiles* tiles, int index) {
+    int* link = &tiles->buckets[hashKey(tiles->entries[index].key)];
+    while (*link != index) link = &tiles->entries[*link].next;
+    *link = tiles->entries[index].next;
+}
+
+// Generations wrap, so compare by difference
+static bool isOlder(unsigned int generation, unsigned int than) {
+    return (int)(generation - than) < 0;
+}
+
+// Least recently used tile not needed by the last frame's view, or -1
+static int findEvictable(const MapTiles* tiles) {
+    int oldest = -1;
+    for (int i = 0; i < tiles->entryCount; i++) {
+        const TileEntry* entry = &tiles->entries[i];
+        if (entry->lastUsed + 1 >= tiles->frame) continue;
+        if (oldest < 0 || entry->lastUsed < tiles->entries[oldest].lastUsed) oldest = i;
+    }
+    return oldest;
+}
+
+static void storeTile(MapTiles* tiles, const TileResult* result) {
+    int index = findEntry(tiles, result->key);
+    if (index >= 0) {
+        TileEntry* entry = &tiles->entries[index];
+        if (isOlder(result->generation, entry->generation)) return;
+        UpdateTexture(entry->texture, result->image.data);
+        entry->generation = result->generation;
+        return;
+    }
+
+    if (tiles->entryCount < tiles->entryCapacity) {
+        index = tiles->entryCount++;
+    } else {
+        // Over budget: the tile is dropped if everything cached is on screen
+        index = findEvictable(tiles);
+        if (index < 0) return;
+        unlinkEntry(tiles, index);
+        UnloadTexture(tiles->entries[index].texture);
+    }
+
+    TileEntry* entry = &tiles->entries[index];
+    entry->key = result->key;
+    entry->texture = LoadTextureFromImage(result->image);
+    SetTextureFilter(entry->texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(entry->texture, TEXTURE_WRAP_CLAMP);
+    entry->generation = result->generation;
+    entry->lastUsed = tiles->frame;
+    unsigned int bucket = hashKey(result->key);
+    entry->next = tiles->buckets[bucket];
+    tiles->buckets[bucket] = index;
+}
+
+static bool renderTile(TileWorker* worker, TileKey key, Image* image) {
+    float n = (float)(1 << key.z);
+    RasterView view = {
+        MAP_TILE_WIDTH, MAP_TILE_HEIGHT,
+        { -180.0f + (key.x + 0.5f) * 360.0f / n, 90.0f - (key.y + 0.5f) * 180.0f / n },
+        n, true
+    };
+    return renderMapImage(worker->context, &worker->statuses, view, NULL, image);
+}
+
+// Both called with the lock held
+static void takeRequest(MapTiles* tiles, TileWorker* worker) {
+    worker->busy = tiles->requests[tiles->requestHead++];
+    worker->isBusy = true;
+    if (worker->generation != tiles->generation) {
+        memcpy(worker->statuses.statusByKey, tiles->statusByKey, sizeof(tiles->statusByKey));
+        worker->generation = tiles->generation;
+    }
+}
+
+static void finishRequest(MapTiles* tiles, TileWorker* worker, Image image, bool ok) {
+    worker->isBusy = false;
+    if (ok && tiles->resultCount == tiles->resultCapacity) {
+        int capacity = tiles->resultCapacity ? tiles->resultCapacity * 2 : 16;
+        TileResult* grown = (TileResult*)realloc(tiles->results, sizeof(TileResult) * capacity);
+        if (grown) {
+            tiles->results = grown;
+            tiles->resultCapacity = capacity;
+        } else {
+            ok = false;
+        }
+    }
+    if (ok) {
+        tiles->results[tiles->resultCount++] = (TileResult){ worker->busy, worker->generation, image };
+    } else if (image.data) {
+        UnloadImage(image);
+    }
+}
+
+static void runRequest(MapTiles* tiles, TileWorker* worker) {
+    Image image = { 0 };
+    PROF_BEGIN(PROF_TILE_RENDER);
+    bool ok = renderTile(worker, worker->busy, &image);
+    PROF_END(PROF_TILE_RENDER);
+
+    lockTiles(tiles);
+    finishRequest(tiles, worker, image, ok);
+    unlockTiles(tiles);
+}
+
+#ifdef TT_THREADS
+static void* workerMain(void* arg) {
+    TileWorker* worker = (TileWorker*)arg;
+    MapTiles* tiles = worker->tiles;
+
+    pthread_mutex_lock(&tiles->lock);
+    for (;;) {
+        while (!tiles->stopping && tiles->requestHead == tiles->requestCount) {
+            pthread_cond_wait(&tiles->wake, &tiles->lock);
+        }
+        if (tiles->stopping) break;
+        takeRequest(tiles, worker);
+        pthread_mutex_unlock(&tiles->lock);
+
+        runRequest(tiles, worker);
+
+        pthread_mutex_lock(&tiles->lock);
+    }
+    pthread_mutex_unlock(&tiles->lock);
+    return NULL;
+}
+#endif
+
+static long getTileBudget(long budgetBytes) {
+    if (budgetBytes > 0) return budgetBytes;
+    const char* env = getenv(MAP_TILE_BUDGET_ENV);
+    long megabytes = env ? atol(env) : 0;
+    return megabytes > 0 ? megabytes * 1024 * 1024 : MAP_TILE_DEFAULT_BUDGET;
+}
+
+MapTiles* loadMapTiles(const WorldMap* map, long budgetBytes) {
+    if (!map) return NULL;
+    MapTiles* tiles = (MapTiles*)calloc(1, sizeof(MapTiles));
+    if (!tiles) return NULL;
+
+    long tileBytes = (long)MAP_TILE_WIDTH * MAP_TILE_HEIGHT * 4;
+    long capacity = getTileBudget(budgetBytes) / tileBytes;
+    tiles->entryCapacity = capacity > MAP_TILE_MIN_ENTRIES ? (int)capacity : MAP_TILE_MIN_ENTRIES;
+    tiles->entries = (TileEntry*)malloc(sizeof(TileEntry) * tiles->entryCapacity);
+    for (int i = 0; i < MAP_TILE_BUCKETS; i++) tiles->buckets[i] = -1;
+
+#ifdef TT_THREADS
+    int workerCount = MAP_TILE_WORKERS;
+#else
+    int workerCount = 1;    // Renders inline from updateMapTiles
+#endif
+    bool ok = tiles->entries != NULL;
+    for (int i = 0; ok && i < workerCount; i++) {
+        tiles->workers[i].tiles = tiles;
+        tiles->workers[i].context = createRasterContext(map, 1);
+        tiles->workers[i].generation = (unsigned int)-1;
+        ok = tiles->workers[i].context != NULL;
+    }
+    if (!ok) {
+        for (int i = 0; i < workerCount; i++) destroyRasterContext(tiles->workers[i].context);
+        free(tiles->entries);
+        free(tiles);
+        return NULL;
+    }
+
+#ifdef TT_THREADS
+    pthread_mutex_init(&tiles->lock, NULL);
+    pthread_cond_init(&tiles->wake, NULL);
+    for (int i = 0; i < workerCount; i++) {
+        if (pthread_create(&tiles->workers[i].thread, NULL, workerMain, &tiles->workers[i]) != 0) break;
+        tiles->workerCount++;
+    }
+#else
+    tiles->workerCount = workerCount;
+#endif
+    return tiles;
+}
+
+void unloadMapTiles(MapTiles* tiles) {
+    if (!tiles) return;
+
+#ifdef TT_THREADS
+    pthread_mutex_lock(&tiles->lock);
+    tiles->stopping = true;
+    pthread_cond_broadcast(&tiles->wake);
+    pthread_mutex_unlock(&tiles->lock);
+    for (int i = 0; i < tiles->workerCount; i++) pthread_join(tiles->workers[i].thread, NULL);
+    pthread_cond_destroy(&tiles->wake);
+    pthread_mutex_destroy(&tiles->lock);
+#endif
+
+    for (int i = 0; i < MAP_TILE_WORKERS; i++) destroyRasterContext(tiles->workers[i].context);
+    for (int i = 0; i < tiles->resultCount; i++) UnloadImage(tiles->results[i].image);
+    for (int i = 0; i < tiles->entryCount; i++) UnloadTexture(tiles->entries[i].texture);
+    free(tiles->results);
+    free(tiles->entries);
+    free(tiles);
+}
+
+// Coarsest level whose tiles are not magnified at this zoom
+static int selectTileLevel(float zoom) {
+    float tilesAcross = SCREEN_WIDTH * zoom / MAP_TILE_WIDTH;
+    int level = (int)ceilf(log2f(tilesAcross) - 0.01f);
+    if (level < 0) return 0;
+    return level > MAP_TILE_MAX_LEVEL ? MAP_TILE_MAX_LEVEL : level;
+}
+
+static void getTileRange(const WorldMap* map, int level, int* x0, int* y0, int* x1, int* y1) {
+    int n = 1 << level;
+    float tileWidth = SCREEN_WIDTH * map->zoom / n;
+    float tileHeight = SCREEN_HEIGHT * map->zoom / n;
+    *x0 = (int)floorf(-map->offset.x / tileWidth);
+    *y0 = (int)floorf(-map->offset.y / tileHeight);
+    *x1 = (int)floorf((GetScreenWidth() - map->offset.x) / tileWidth);
+    *y1 = (int)floorf((GetScreenHeight() - map->offset.y) / tileHeight);
+    if (*x0 < 0) *x0 = 0;
+    if (*y0 < 0) *y0 = 0;
+    if (*x1 > n - 1) *x1 = n - 1;
+    if (*y1 > n - 1) *y1 = n - 1;
+}
+
+// The tile itself, stale or current, or else its nearest cached ancestor
+static int findDrawable(const MapTiles* tiles, TileKey key) {
+    for (; key.z >= 0; key.z--, key.x >>= 1, key.y >>= 1) {
+        int index = findEntry(tiles, key);
+        if (index >= 0) return index;
+    }
+    return -1;
+}
+
+static int compareRequests(const void* a, const void* b) {
+    const TileRequest* x = (const TileRequest*)a;
+    const TileRequest* y = (const TileRequest*)b;
+    if (x->key.z != y->key.z) return x->key.z - y->key.z;
+    return x->distance - y->distance;
+}
+
+// Marks what the view at `level` draws as used and lists the tiles that are
+// missing or stale. Returns false if some part of the view has nothing to draw.
+static bool collectRequests(MapTiles* tiles, const WorldMap* map, int level,
+                            TileRequest* requests, int* requestCount) {
+    int x0, y0, x1, y1;
+    getTileRange(map, level, &x0, &y0, &x1, &y1);
+    int centerX = (x0 + x1) / 2, centerY = (y0 + y1) / 2;
+
+    bool covered = true;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            TileKey key = { level, x, y };
+            int index = findDrawable(tiles, key);
+            if (index < 0) {
+                covered = false;
+            } else {
+                tiles->entries[index].lastUsed = tiles->frame;
+            }
+
+            bool current = index >= 0 && sameKey(tiles->entries[index].key, key) &&
+                           tiles->entries[index].generation == tiles->generation;
+            if (!current && *requestCount < MAP_TILE_MAX_REQUESTS) {
+                int distance = (x - centerX) * (x - centerX) + (y - centerY) * (y - centerY);
+                requests[(*requestCount)++] = (TileRequest){ key, distance };
+            }
+        }
+    }
+    return covered;
+}
+
+static bool isInFlight(const MapTiles* tiles, TileKey key) {
+    for (int i = 0; i < tiles->workerCount; i++) {
+        const TileWorker* worker = &tiles->workers[i];
+        if (worker->isBusy && sameKey(worker->busy, key) && worker->generation == tiles->generation) return true;
+    }
+    for (int i = 0; i < tiles->resultCount; i++) {
+        if (sameKey(tiles->results[i].key, key) && tiles->results[i].generation == tiles->generation) return true;
+    }
+    return false;
+}
+
+bool updateMapTiles(MapTiles* tiles, const WorldMap* map, const CountryStatusList* statusList) {
+    if (!tiles) return false;
+    tiles->frame++;
+
+    TileResult uploads[MAP_TILE_UPLOADS_PER_FRAME];
+    lockTiles(tiles);
+    if (statusList && (!tiles->hasStatuses || statusList->version != tiles->statusVersion)) {
+        memcpy(tiles->statusByKey, statusList->statusByKey, sizeof(tiles->statusByKey));
+        tiles->generation++;
+        tiles->statusVersion = statusList->version;
+        tiles->hasStatuses = true;
+    }
+    int uploadCount = tiles->resultCount < MAP_TILE_UPLOADS_PER_FRAME ? tiles->resultCount : MAP_TILE_UPLOADS_PER_FRAME;
+    memcpy(uploads, tiles->results, sizeof(TileResult) * uploadCount);
+    tiles->resultCount -= uploadCount;
+    memmove(tiles->results, tiles->results + uploadCount, sizeof(TileResult) * tiles->resultCount);
+    unlockTiles(tiles);
+
+    // Uploads stay on the main thread, which owns the GL context
+    for (int i = 0; i < uploadCount; i++) {
+        storeTile(tiles, &uploads[i]);
+        UnloadImage(uploads[i].image);
+    }
+
+    tiles->active = map->zoom >= MAP_TILES_MIN_ZOOM;
+    if (!tiles->active) {
+        lockTiles(tiles);
+        tiles->requestHead = tiles->requestCount = 0;
+        unlockTiles(tiles);
+        return false;
+    }
+
+    tiles->level = selectTileLevel(map->zoom);
+    getTileRange(map, tiles->level, &tiles->x0, &tiles->y0, &tiles->x1, &tiles->y1);
+
+    // A handful of coarse tiles covers the view quickly and is what gets
+    // drawn while the finer ones are pending, so they are rendered first
+    TileRequest requests[MAP_TILE_MAX_REQUESTS];
+    int requestCount = 0;
+    int coarse = tiles->level - MAP_TILE_COARSE_LEVELS;
+    if (coarse >= 0) collectRequests(tiles, map, coarse, requests, &requestCount);
+    bool covered = collectRequests(tiles, map, tiles->level, requests, &requestCount);
+    qsort(requests, requestCount, sizeof(TileRequest), compareRequests);
+
+    // The queue is replaced every frame, so tiles that scrolled away are dropped
+    lockTiles(tiles);
+    tiles->requestHead = tiles->requestCount = 0;
+    for (int i = 0; i < requestCount; i++) {
+        if (!isInFlight(tiles, requests[i].key)) tiles->requests[tiles->requestCount++] = requests[i].key;
+    }
+#ifdef TT_THREADS
+    if (tiles->requestCount > 0) pthread_cond_broadcast(&tiles->wake);
+#endif
+    unlockTiles(tiles);
+
+#ifndef TT_THREADS
+    // One tile per frame inline, picked up by the next update
+    if (tiles->requestCount > 0) {
+        takeRequest(tiles, &tiles->workers[0]);
+        runRequest(tiles, &tiles->workers[0]);
+    }
+#endif
+
+    return covered && map->zoom >= MAP_TILES_MIN_ZOOM;
+}
+
+void drawMapTiles(const MapTiles* tiles, const WorldMap* map) {
+    if (!tiles || !tiles->active) return;
+
+    int n = 1 << tiles->level;
+    float tileWidth = SCREEN_WIDTH * map->zoom / n;
+    float tileHeight = SCREEN_HEIGHT * map->zoom / n;
+
+    for (int y = tiles->y0; y <= tiles->y1; y++) {
+        for (int x = tiles->x0; x <= tiles->x1; x++) {
+            TileKey key = { tiles->level, x, y };
+            int index = findDrawable(tiles, key);
+            if (index < 0) continue;
+            const TileEntry* entry = &tiles->entries[index];
+
+            // An ancestor is drawn from the part of it this tile covers
+            int depth = tiles->level - entry->key.z;
+            float parts = (float)(1 << depth);
+            Rectangle source = {
+                (x - (entry->key.x << depth)) * MAP_TILE_WIDTH / parts,
+                (y - (entry->key.y << depth)) * MAP_TILE_HEIGHT / parts,
+                MAP_TILE_WIDTH / parts,
+                MAP_TILE_HEIGHT / parts
+            };
+
+            // Snapped to whole pixels so neighbours meet without seams
+            float left = roundf(map->offset.x + x * tileWidth);
+            float top = roundf(map->offset.y + y * tileHeight);
+            Rectangle dest = {
+                left, top,
+                roundf(map->offset.x + (x + 1) * tileWidth) - left,
+                roundf(map->offset.y + (y + 1) * tileHeight) - top
+            };
+            DrawTexturePro(entry->texture, source, dest, (Vector2){ 0, 0 }, 0.0f, WHITE);
+        }
+    }
+}
@@ -1,4 +1,14 @@
 #include "map_utils.h"
+#include "map_builder.h"
+#include "spatial_index.h"
+#include "picking.h"
+#include "map_lod.h"
+#include "map_file.h"
+#include "json_stream.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include "projection.h"
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -41,148 +51,46 @@ const char* getIsoCode(JSON_Object* properties) {
 }
 
 
-int findOrCreateCountry(WorldMap* map, const char* countryName, const char* isoCode, int polygonIndex) {
-    // Find existing country
-    int countryIdx = -1;
-    for (int i = 0; i < map->countryCount; i++) {
-        if (strcmp(map->countries[i].name, countryName) == 0) {
-            countryIdx = i;
-            break;
-        }
-    }
-
-    // Create new country if not found
-    if (countryIdx == -1) {
-        countryIdx = map->countryCount;
-        strncpy(map->countries[map->countryCount].name, countryName, 255);
-        map->countries[map->countryCount].name[255] = '\0';
-        map->countries[map->countryCount].iso_code[0] = tolower(isoCode[0]);
-        map->countries[map->countryCount].iso_code[1] = tolower(isoCode[1]);
-        map->countries[map->countryCount].iso_code[2] = '\0';
-        map->countries[map->countryCount].polygonStart = polygonIndex;
-        map->countries[map->countryCount].polygonCount = 0;
-        map->countryCount++;
-    }
-
-    return countryIdx;
-}
-
-void parsePolygon(JSON_Array* coordinates, WorldMap* map, int* polygonIndex, const char* countryName, const char* isoCode) {
-    if (!coordinates || !map || !polygonIndex || !countryName || !isoCode) return;
+// Appends the outer ring of a GeoJSON polygon (holes are ignored)
+static bool parseRing(JSON_Array* polygon, MapBuilder* builder) {
+    JSON_Array* ring = json_array_get_array(polygon, 0);
+    if (!ring) return true;
 
-    JSON_Array* polygon = json_array_get_array(coordinates, 0);
-    if (!polygon) return;
-
-    size_t pointCount = json_array_get_count(polygon);
-    if (pointCount == 0) return;
-
-    Vector2* points = (Vector2*)malloc(pointCount * sizeof(Vector2));
-    if (!points) return;
-
-    int countryIdx = findOrCreateCountry(map, countryName, isoCode, *polygonIndex);
-    map->countries[countryIdx].polygonCount++;
-
-    map->polygons[*polygonIndex].points = points;
-    map->polygons[*polygonIndex].numPoints = pointCount;
-    map->polygons[*polygonIndex].color = DEFAULT_LAND_COLOR;
-
-    // Initialize bounds with the first point
-    JSON_Array* firstPoint = json_array_get_array(polygon, 0);
-    float firstLon = (float)json_array_get_number(firstPoint, 0);
-    float firstLat = (float)json_array_get_number(firstPoint, 1);
-    
-    map->polygonBounds[*polygonIndex].bounds = (Rectangle){
-        firstLon, firstLat, firstLon, firstLat
-    };
+    size_t pointCount = json_array_get_count(ring);
+    mapBuilderBeginRing(builder);
 
     for (size_t j = 0; j < pointCount; j++) {
-        JSON_Array* point = json_array_get_array(polygon, j);
+        JSON_Array* point = json_array_get_array(ring, j);
         if (!point) continue;
         float lon = (float)json_array_get_number(point, 0);
         float lat = (float)json_array_get_number(point, 1);
-        points[j] = (Vector2){lon, lat};
-        
-        // Update coordinate bounds
-        if (lon < map->polygonBounds[*polygonIndex].bounds.x)
-            map->polygonBounds[*polygonIndex].bounds.x = lon;
-        if (lon > map->polygonBounds[*polygonIndex].bounds.width)
-            map->polygonBounds[*polygonIndex].bounds.width = lon;
-        if (lat < map->polygonBounds[*polygonIndex].bounds.y)
-            map->polygonBounds[*polygonIndex].bounds.y = lat;
-        if (lat > map->polygonBounds[*polygonIndex].bounds.height)
-            map->polygonBounds[*polygonIndex].bounds.height = lat;
+        if (!mapBuilderAddPoint(builder, (Vector2){lon, lat})) return false;
     }
 
-    map->polygonBounds[*polygonIndex].bounds.width -= map->polygonBounds[*polygonIndex].bounds.x;
-    map->polygonBounds[*polygonIndex].bounds.height -= map->polygonBounds[*polygonIndex].bounds.y;
-    map->polygonBounds[*polygonIndex].isVisible = true;
+    return mapBuilderCommitRing(builder);
+}
 
-    (*polygonIndex)++;
+bool parsePolygon(JSON_Array* coordinates, MapBuilder* builder) {
+    if (!coordinates || !builder) return false;
+    return parseRing(coordinates, builder);
 }
 
-void parseMultiPolygon(JSON_Array* coordinates, WorldMap* map, int* polygonIndex, const char* countryName, const char* isoCode) {
-    if (!coordinates || !map || !polygonIndex || !countryName || !isoCode) return;
+bool parseMultiPolygon(JSON_Array* coordinates, MapBuilder* builder) {
+    if (!coordinates || !builder) return false;
 
     size_t polyCount = json_array_get_count(coordinates);
-    int countryIdx = findOrCreateCountry(map, countryName, isoCode, *polygonIndex);
-
     for (size_t i = 0; i < polyCount; i++) {
         JSON_Array* polygon = json_array_get_array(coordinates, i);
         if (!polygon) continue;
-
-        JSON_Array* ring = json_array_get_array(polygon, 0);
-        if (!ring) continue;
-
-        size_t pointCount = json_array_get_count(ring);
-        if (pointCount == 0) continue;
-
-        Vector2* points = (Vector2*)malloc(pointCount * sizeof(Vector2));
-        if (!points) continue;
-
-        map->polygons[*polygonIndex].points = points;
-        map->polygons[*polygonIndex].numPoints = pointCount;
-        map->polygons[*polygonIndex].color = DEFAULT_LAND_COLOR;
-
-        map->polygonBounds[*polygonIndex].isVisible = true;
-        map->polygonBounds[*polygonIndex].bounds = (Rectangle){
-            FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX
-        };
-
-        for (size_t j = 0; j < pointCount; j++) {
-            JSON_Array* point = json_array_get_array(ring, j);
-            if (!point) continue;
-            float lon = (float)json_array_get_number(point, 0);
-            float lat = (float)json_array_get_number(point, 1);
-            points[j] = (Vector2){lon, lat};
-
-            if (lon < map->polygonBounds[*polygonIndex].bounds.x)
-                map->polygonBounds[*polygonIndex].bounds.x = lon;
-            if (lon > map->polygonBounds[*polygonIndex].bounds.width)
-                map->polygonBounds[*polygonIndex].bounds.width = lon;
-            if (lat < map->polygonBounds[*polygonIndex].bounds.y)
-                map->polygonBounds[*polygonIndex].bounds.y = lat;
-            if (lat > map->polygonBounds[*polygonIndex].bounds.height)
-                map->polygonBounds[*polygonIndex].bounds.height = lat;
-        }
-
-        map->polygonBounds[*polygonIndex].bounds.width -= map->polygonBounds[*polygonIndex].bounds.x;
-        map->polygonBounds[*polygonIndex].bounds.height -= map->polygonBounds[*polygonIndex].bounds.y;
-
-        map->countries[countryIdx].polygonCount++;
-        (*polygonIndex)++;
+        if (!parseRing(polygon, builder)) return false;
     }
+    return true;
 }
 
-WorldMap* loadWorldMap(const char* filename) {
-    WorldMap* map = (WorldMap*)malloc(sizeof(WorldMap));
-    map->offset = (Vector2){0, 0};
-    map->zoom = 1.0f;
-    map->countryCount = 0;
-    
+WorldMap* loadWorldMapParson(const char* filename) {
     char* jsonData = LoadFileText(filename);
     if (!jsonData) {
         printf("Failed to load file: %s\n", filename);
-        free(map);
         return NULL;
     }
 
@@ -190,22 +98,22 @@ WorldMap* loadWorldMap(const char* filename) {
     if (!root) {
         printf("Failed to parse JSON\n");
         UnloadFileText(jsonData);
-        free(map);
+        return NULL;
+    }
+
+    MapBuilder builder;
+    if (!mapBuilderInit(&builder)) {
+        json_value_free(root);
+        UnloadFileText(jsonData);
         return NULL;
     }
 
     JSON_Object* root_object = json_value_get_object(root);
     JSON_Array* features = json_object_get_array(root_object, "features");
     size_t featureCount = json_array_get_count(features);
+    bool ok = true;
 
-    map->countries = (Country*)calloc(featureCount, sizeof(Country));
-    map->polygons = (Polygon*)calloc(featureCount * 10, sizeof(Polygon));
-    map->polygonBounds = (PolygonBounds*)calloc(featureCount * 10, sizeof(PolygonBounds));
-    map->flags = (CountryFlag*)calloc(featureCount, sizeof(CountryFlag)); 
-    map->numPolygons = 0;
-    
-
-    for (size_t i = 0; i < featureCount; i++) {
+    for (size_t i = 0; ok && i < featureCount; i++) {
         JSON_Object* feature = json_array_get_object(features, i);
         JSON_Object* properties = json_object_get_object(feature, "properties");
         const char* countryName = json_object_get_string(properties, "name");
@@ -222,235 +130,616 @@ WorldMap* loadWorldMap(const char* filename) {
         JSON_Array* coordinates = json_object_get_array(geometry, "coordinates");
         if (!coordinates) continue;
 
+        int firstPolygon = builder.map->numPolygons;
         if (strcmp(type, "Polygon") == 0) {
-            parsePolygon(coordinates, map, &map->numPolygons, countryName, isoCode);  // Add isoCode
+            ok = parsePolygon(coordinates, &builder);
         }
         else if (strcmp(type, "MultiPolygon") == 0) {
-            parseMultiPolygon(coordinates, map, &map->numPolygons, countryName, isoCode);  // Add isoCode
+            ok = parseMultiPolygon(coordinates, &builder);
         }
-
-
-        map->countries[map->countryCount].iso_code[0] = tolower(isoCode[0]);
-        map->countries[map->countryCount].iso_code[1] = tolower(isoCode[1]);
-        map->countries[map->countryCount].iso_code[2] = '\0';
+        ok = ok && mapBuilderEndFeature(&builder, firstPolygon, countryName, isoCode, true);
     }
 
     json_value_free(root);
     UnloadFileText(jsonData);
-    return map;
+
+    if (!ok) {
+        mapBuilderAbort(&builder);
+        return NULL;
+    }
+    return mapBuilderFinish(&builder);
 }
-void drawWorldMap(WorldMap* map, const char* selectedCountry, CountryStatusList* statusList) {
-    // Calculate visible coordinate ranges
-    float leftLon = screenXToLongitude(0, map->zoom, map->offset.x);
-    float rightLon = screenXToLongitude(SCREEN_WIDTH, map->zoom, map->offset.x);
-    float topLat = screenYToLatitude(0, map->zoom, map->offset.y);
-    float bottomLat = screenYToLatitude(SCREEN_HEIGHT, map->zoom, map->offset.y);
 
-    int visibleCount = 0;
-    
-    for (int i = 0; i < map->numPolygons; i++) {
-        Polygon* poly = &map->polygons[i];
-        
-        // Find polygon bounds in world coordinates
-        float minLon = FLT_MAX, maxLon = -FLT_MAX;
-        float minLat = FLT_MAX, maxLat = -FLT_MAX;
-        
-        for (int j = 0; j < poly->numPoints; j++) {
-            float lon = poly->points[j].x;
-            float lat = poly->points[j].y;
-            
-            minLon = fminf(minLon, lon);
-            maxLon = fmaxf(maxLon, lon);
-            minLat = fminf(minLat, lat);
-            maxLat = fmaxf(maxLat, lat);
+// Reads one coordinates array and returns its nesting depth (1 for a point,
+// 2 for a ring, 3 for a polygon...), 0 for an empty array, -1 on error. The
+// first ring of every polygon is committed; holes are read and dropped.
+static int readCoordinates(JsonStream* s, MapBuilder* builder) {
+    if (!jsonExpect(s, '[')) return -1;
+
+    int c = jsonPeek(s);
+    bool first = true;
+
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        double values[2] = { 0.0, 0.0 };
+        int count = 0;
+        while (jsonNextElement(s, &first)) {
+            double value;
+            if (!jsonReadNumber(s, &value)) return -1;
+            if (count < 2) values[count] = value;
+            count++;
         }
+        if (s->failed) return -1;
 
-        // Check if polygon is visible
-        bool isVisible = !(maxLon < leftLon || minLon > rightLon || 
-                         maxLat < bottomLat || minLat > topLat);
+        if (!mapBuilderAddPoint(builder, (Vector2){ (float)values[0], (float)values[1] })) return -1;
+        return 1;
+    }
 
-        if (!isVisible) {
-            continue;
+    // Nested array: if it turns out to be a ring, it starts from scratch
+    mapBuilderBeginRing(builder);
+
+    int depth = 0;
+    int index = 0;
+    while (jsonNextElement(s, &first)) {
+        int childDepth = readCoordinates(s, builder);
+        if (childDepth < 0) return -1;
+
+        if (childDepth == 2 && index == 0 && !mapBuilderCommitRing(builder)) return -1;
+        if (childDepth + 1 > depth) depth = childDepth + 1;
+        index++;
+    }
+    return s->failed ? -1 : depth;
+}
+
+static bool readGeometry(JsonStream* s, MapBuilder* builder, char* type, size_t typeSize) {
+    type[0] = '\0';
+    if (jsonPeek(s) != '{') return jsonSkipValue(s);
+    s->pos++;
+
+    bool first = true;
+    char key[32];
+    while (jsonNextKey(s, &first, key, sizeof(key))) {
+        bool ok;
+        if (strcmp(key, "type") == 0) {
+            ok = jsonReadOptionalString(s, type, typeSize);
+        } else if (strcmp(key, "coordinates") == 0 && jsonPeek(s) == '[') {
+            ok = readCoordinates(s, builder) >= 0;
+        } else {
+            ok = jsonSkipValue(s);
         }
+        if (!ok) return false;
+    }
+    return !s->failed;
+}
 
-        visibleCount++;
+static bool readProperties(JsonStream* s, char* name, char* isoA2, char* isoA2Eh) {
+    if (jsonPeek(s) != '{') return jsonSkipValue(s);
+    s->pos++;
+
+    bool first = true;
+    char key[32];
+    while (jsonNextKey(s, &first, key, sizeof(key))) {
+        bool ok;
+        if (strcmp(key, "name") == 0) {
+            ok = jsonReadOptionalString(s, name, 256);
+        } else if (strcmp(key, "iso_a2") == 0) {
+            ok = jsonReadOptionalString(s, isoA2, 8);
+        } else if (strcmp(key, "iso_a2_eh") == 0) {
+            ok = jsonReadOptionalString(s, isoA2Eh, 8);
+        } else {
+            ok = jsonSkipValue(s);
+        }
+        if (!ok) return false;
+    }
+    return !s->failed;
+}
 
-        Color drawColor = DEFAULT_LAND_COLOR;
-        
-        for (int c = 0; c < map->countryCount; c++) {
-            Country* country = &map->countries[c];
-            bool isCountryPolygon = false;
-            
-            for (int p = 0; p < country->polygonCount; p++) {
-                if (i == country->polygonStart + p) {
-                    isCountryPolygon = true;
-                    
-                    int status = GetCountryStatus(statusList, country->iso_code);
-                    bool isSelected = selectedCountry && strcmp(country->name, selectedCountry) == 0;
-                    
-                   switch(status) {
-                        case STATUS_BEEN:
-                            drawColor = isSelected ? STATUS_BEEN_SELECTED_COLOR : STATUS_BEEN_COLOR;
-                            break;
-                        case STATUS_LIVED:
-                            drawColor = isSelected ? STATUS_LIVED_SELECTED_COLOR : STATUS_LIVED_COLOR;
-                            break;
-                        case STATUS_WANT:
-                            drawColor = isSelected ? STATUS_WANT_SELECTED_COLOR : STATUS_WANT_COLOR;
-                            break;
-                        case STATUS_NONE:
-                        default:
-                            drawColor = isSelected ? STATUS_NONE_SELECTED_COLOR : STATUS_NONE_COLOR;
-                            break;
-                    }
+static bool readFeature(JsonStream* s, MapBuilder* builder) {
+    if (jsonPeek(s) != '{') return jsonSkipValue(s);
+    s->pos++;
+
+    int firstPolygon = builder->map->numPolygons;
+    char name[256] = "", isoA2[8] = "", isoA2Eh[8] = "", type[32] = "";
+
+    bool first = true;
+    char key[32];
+    while (jsonNextKey(s, &first, key, sizeof(key))) {
+        bool ok;
+        if (strcmp(key, "properties") == 0) {
+            ok = readProperties(s, name, isoA2, isoA2Eh);
+        } else if (strcmp(key, "geometry") == 0) {
+            ok = readGeometry(s, builder, type, sizeof(type));
+        } else {
+            ok = jsonSkipValue(s);
+        }
+        if (!ok) return false;
+    }
+    if (s->failed) return false;
+
+    // Same fallback as getIsoCode: iso_a2, then iso_a2_eh, "-99" is missing
+    const char* isoCode = isoA2;
+    if (isoCode[0] == '\0' || strcmp(isoCode, "-99") == 0) isoCode = isoA2Eh;
+    bool validIso = isoCode[0] != '\0' && strcmp(isoCode, "-99") != 0;
+    bool validType = strcmp(type, "Polygon") == 0 || strcmp(type, "MultiPolygon") == 0;
+
+    return mapBuilderEndFeature(builder, firstPolygon, name, isoCode, name[0] != '\0' && validIso && validType);
+}
+
+// Streaming GeoJSON loader: walks the file once through a JsonStream and
+// writes rings straight into the map, so no document tree is ever built.
+static WorldMap* loadGeoJSONStreaming(const char* filename, ThreadPool* pool) {
+    JsonStream stream;
+    if (!jsonStreamOpenFile(&stream, filename)) {
+        printf("Failed to load file: %s\n", filename);
+        return NULL;
+    }
+
+    MapBuilder builder;
+    if (!mapBuilderInit(&builder)) {
+        jsonStreamClose(&stream);
+        return NULL;
+    }
+    builder.pool = pool;
+
+    bool ok = jsonExpect(&stream, '{');
+    bool first = true;
+    char key[32];
+    while (ok && jsonNextKey(&stream, &first, key, sizeof(key))) {
+        if (strcmp(key, "features") == 0 && jsonPeek(&stream) == '[') {
+            stream.pos++;
+            bool firstFeature = true;
+            while (ok && jsonNextElement(&stream, &firstFeature)) {
+                ok = readFeature(&stream, &builder);
+            }
+        } else {
+            ok = jsonSkipValue(&stream);
+        }
+    }
+    ok = ok && !stream.failed;
+
+    if (!ok) {
+        printf("Failed to parse JSON near byte %zu\n", stream.consumed + stream.pos);
+    }
+    jsonStreamClose(&stream);
+
+    if (!ok) {
+        mapBuilderAbort(&builder);
+        return NULL;
+    }
+    return mapBuilderFinish(&builder);
+}
+
+#ifdef TT_THREADS
+// Features are grouped into chunks of about this many bytes of JSON. Chunk
+// boundaries only depend on the file, never on the number of threads.
+#define LOAD_CHUNK_BYTES (256 * 1024)
+
+typedef struct {
+    const char* data;
+    const size_t* featureStart;     // featureCount + 1 byte offsets
+    const size_t* featureEnd;
+    const int* chunkFirst;          // chunkCount + 1 feature indices
+    MapBuilder* builders;           // One per chunk
+    bool* chunkOk;
+    size_t* failedAt;
+} ParallelLoad;
+
+static void loadChunkTask(void* context, int chunk, int worker) {
+    (void)worker;
+    ParallelLoad* load = (ParallelLoad*)context;
+    MapBuilder* builder = &load->builders[chunk];
+
+    bool ok = mapBuilderInit(builder);
+    for (int f = load->chunkFirst[chunk]; ok && f < load->chunkFirst[chunk + 1]; f++) {
+        JsonStream stream;
+        jsonStreamOpenMemory(&stream, load->data + load->featureStart[f], load->featureEnd[f] - load->featureStart[f]);
+        ok = readFeature(&stream, builder) && !stream.failed;
+        if (!ok) load->failedAt[chunk] = load->featureStart[f] + stream.pos;
+    }
+    load->chunkOk[chunk] = ok;
+}
+
+static char* readWholeFile(const char* filename, size_t* size) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = length >= 0 ? (char*)malloc(length + 1) : NULL;
+    if (data && fread(data, 1, length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    if (data) *size = (size_t)length;
+    return data;
+}
+
+// Finds the byte range of every feature with a cheap skip over the JSON,
+// returning the number found or -1 on a syntax error
+static int scanFeatures(const char* data, size_t size, size_t** starts, size_t** ends) {
+    JsonStream stream;
+    jsonStreamOpenMemory(&stream, data, size);
+
+    int count = 0, capacity = 0;
+    *starts = *ends = NULL;
+
+    bool ok = jsonExpect(&stream, '{');
+    bool first = true;
+    char key[32];
+    while (ok && jsonNextKey(&stream, &first, key, sizeof(key))) {
+        if (strcmp(key, "features") != 0 || jsonPeek(&stream) != '[') {
+            ok = jsonSkipValue(&stream);
+            continue;
+        }
+        stream.pos++;
+        bool firstFeature = true;
+        while (ok && jsonNextElement(&stream, &firstFeature)) {
+            if (count == capacity) {
+                capacity = capacity > 0 ? capacity * 2 : 256;
+                size_t* grownStarts = (size_t*)realloc(*starts, capacity * sizeof(size_t));
+                if (grownStarts) *starts = grownStarts;
+                size_t* grownEnds = (size_t*)realloc(*ends, capacity * sizeof(size_t));
+                if (grownEnds) *ends = grownEnds;
+                if (!grownStarts || !grownEnds) {
+                    ok = false;
                     break;
                 }
             }
-            if (isCountryPolygon) break;
+            jsonPeek(&stream);
+            (*starts)[count] = stream.pos;
+            ok = jsonSkipValue(&stream);
+            (*ends)[count++] = stream.pos;
         }
+    }
 
-        Vector2* screenPoints = (Vector2*)malloc(poly->numPoints * sizeof(Vector2));
-        if (!screenPoints) continue;
+    if (!ok || stream.failed) {
+        printf("Failed to parse JSON near byte %zu\n", stream.pos);
+        free(*starts);
+        free(*ends);
+        *starts = *ends = NULL;
+        return -1;
+    }
+    return count;
+}
 
-        // Convert to screen coordinates
-        int minY = SCREEN_HEIGHT;
-        int maxY = 0;
-        
-        for (int j = 0; j < poly->numPoints; j++) {
-            screenPoints[j] = (Vector2){
-                longitudeToScreenX(poly->points[j].x, map->zoom, map->offset.x),
-                latitudeToScreenY(poly->points[j].y, map->zoom, map->offset.y)
-            };
-            
-            minY = fminf(minY, screenPoints[j].y);
-            maxY = fmaxf(maxY, screenPoints[j].y);
+// Parallel GeoJSON loader: the file is read whole, split into runs of
+// features, and each run is parsed, triangulated and bounded by its own
+// builder on the pool. The runs are then appended in file order, so the map
+// comes out exactly as the streaming loader would produce it.
+static WorldMap* loadGeoJSONParallel(const char* filename, ThreadPool* pool) {
+    size_t size = 0;
+    char* data = readWholeFile(filename, &size);
+    if (!data) {
+        printf("Failed to load file: %s\n", filename);
+        return NULL;
+    }
+
+    size_t* starts = NULL;
+    size_t* ends = NULL;
+    int featureCount = scanFeatures(data, size, &starts, &ends);
+    if (featureCount < 0) {
+        free(data);
+        return NULL;
+    }
+
+    int* chunkFirst = (int*)malloc((featureCount + 2) * sizeof(int));
+    int chunkCount = 0;
+    for (int f = 0; chunkFirst && f < featureCount; ) {
+        chunkFirst[chunkCount++] = f;
+        size_t chunkStart = starts[f];
+        while (f < featureCount && ends[f] - chunkStart < LOAD_CHUNK_BYTES) f++;
+        if (f < featureCount && chunkFirst[chunkCount - 1] == f) f++;
+    }
+    if (chunkFirst) chunkFirst[chunkCount] = featureCount;
+
+    ParallelLoad load = {
+        data, starts, ends, chunkFirst,
+        (MapBuilder*)calloc(chunkCount + 1, sizeof(MapBuilder)),
+        (bool*)calloc(chunkCount + 1, sizeof(bool)),
+        (size_t*)calloc(chunkCount + 1, sizeof(size_t))
+    };
+
+    MapBuilder builder = { 0 };
+    bool ok = chunkFirst && load.builders && load.chunkOk && load.failedAt && mapBuilderInit(&builder);
+    if (ok) {
+        builder.pool = pool;
+        parallelFor(pool, chunkCount, loadChunkTask, &load);
+    }
+
+    for (int c = 0; c < chunkCount && load.builders; c++) {
+        if (ok && !load.chunkOk[c]) {
+            printf("Failed to parse JSON near byte %zu\n", load.failedAt[c]);
+            ok = false;
         }
+        ok = ok && mapBuilderAppend(&builder, &load.builders[c]);
+        mapBuilderAbort(&load.builders[c]);
+    }
 
-        // Clip to screen bounds
-        minY = fmaxf(minY, 0);
-        maxY = fminf(maxY, SCREEN_HEIGHT);
-
-        // Fill polygon
-        for (int y = minY; y <= maxY; y++) {
-            int intersections[MAX_POINTS];
-            int intersectionCount = 0;
-            
-            for (int j = 0; j < poly->numPoints; j++) {
-                int k = (j + 1) % poly->numPoints;
-                float y1 = screenPoints[j].y;
-                float y2 = screenPoints[k].y;
-                
-                if ((y1 <= y && y2 > y) || (y2 <= y && y1 > y)) {
-                    float x1 = screenPoints[j].x;
-                    float x2 = screenPoints[k].x;
-                    float x = x1 + (y - y1) * (x2 - x1) / (y2 - y1);
-                    intersections[intersectionCount++] = x;
-                }
-            }
-            
-            // Sort intersections
-            for (int j = 0; j < intersectionCount - 1; j++) {
-                for (int k = 0; k < intersectionCount - j - 1; k++) {
-                    if (intersections[k] > intersections[k + 1]) {
-                        int temp = intersections[k];
-                        intersections[k] = intersections[k + 1];
-                        intersections[k + 1] = temp;
-                    }
-                }
-            }
-            
-            // Draw horizontal lines
-            for (int j = 0; j < intersectionCount - 1; j += 2) {
-                DrawLine(intersections[j], y, intersections[j + 1], y, drawColor);
+    free(load.builders);
+    free(load.chunkOk);
+    free(load.failedAt);
+    free(chunkFirst);
+    free(starts);
+    free(ends);
+    free(data);
+
+    if (!ok) {
+        if (builder.map) mapBuilderAbort(&builder);
+        return NULL;
+    }
+    return mapBuilderFinish(&builder);
+}
+#endif
+
+static WorldMap* loadGeoJSON(const char* filename, ThreadPool* pool) {
+#ifdef TT_THREADS
+    if (getThreadPoolSize(pool) > 1) return loadGeoJSONParallel(filename, pool);
+#endif
+    return loadGeoJSONStreaming(filename, pool);
+}
+
+WorldMap* loadWorldMapGeoJSON(const char* filename) {
+    ThreadPool* pool = createThreadPool(0);
+    WorldMap* map = loadGeoJSON(filename, pool);
+    destroyThreadPool(pool);
+    return map;
+}
+
+typedef struct {
+    WorldMap* map;
+    MapLoadReport report;
+    void* reportContext;
+    atomic_int pickersBuilt;
+} PrepareTask;
+
+// Progress of each stage of loadWorldMapWithProgress, from 0 to 1
+#define LOAD_PROGRESS_INDEX 0.5f
+#define LOAD_PROGRESS_PICKERS 0.6f
+
+static void buildPickerTask(void* context, int level, int worker) {
+    (void)worker;
+    PrepareTask* task = (PrepareTask*)context;
+    task->map->pickers[level] = buildMapPicker(task->map, &task->map->levels[level]);
+
+    int built = atomic_fetch_add_explicit(&task->pickersBuilt, 1, memory_order_relaxed) + 1;
+    if (task->report) {
+        float progress = LOAD_PROGRESS_PICKERS + (1.0f - LOAD_PROGRESS_PICKERS) * built / MAP_LOD_LEVELS;
+        task->report(task->reportContext, "Building pickers", progress);
+    }
+}
+
+// Runtime state shared by both loaders: drawing scratch and indices
+static void prepareWorldMap(WorldMap* map, ThreadPool* pool, MapLoadReport report, void* reportContext) {
+    if (report) report(reportContext, "Indexing", LOAD_PROGRESS_INDEX);
+
+    // Scratch space for projecting one polygon at a time while drawing; a
+    // simplified ring may gain a closing point its source did not have
+    int maxPoints = 1;
+    for (int i = 0; i < map->numPolygons; i++) {
+        if (map->polygons[i].numPoints > maxPoints) maxPoints = map->polygons[i].numPoints;
+    }
+    map->screenPoints = (Vector2*)malloc((maxPoints + 1) * sizeof(Vector2));
+
+    map->spatialIndex = buildSpatialGrid(map->polygonBounds, map->numPolygons);
+    map->visiblePolygons = (int*)malloc((map->numPolygons > 0 ? map->numPolygons : 1) * sizeof(int));
+
+    if (report) report(reportContext, "Building pickers", LOAD_PROGRESS_PICKERS);
+    PrepareTask task = { map, report, reportContext, 0 };
+    parallelFor(pool, MAP_LOD_LEVELS, buildPickerTask, &task);
+}
+
+WorldMap* loadWorldMap(const char* filename) {
+    return loadWorldMapWithProgress(filename, NULL, NULL);
+}
+
+WorldMap* loadWorldMapWithProgress(const char* filename, MapLoadReport report, void* reportContext) {
+    char compiledPath[512];
+    getMapFilePath(filename, compiledPath, sizeof(compiledPath));
+
+    if (report) report(reportContext, "Reading map", 0.0f);
+    ThreadPool* pool = createThreadPool(0);
+    WorldMap* map = loadWorldMapFile(compiledPath, filename);
+    if (!map) map = loadGeoJSON(filename, pool);
+    if (map) prepareWorldMap(map, pool, report, reportContext);
+    destroyThreadPool(pool);
+    return map;
+}
+
+Color getCountryColor(int status, bool isSelected) {
+    switch (status) {
+        case STATUS_BEEN:
+            return isSelected ? STATUS_BEEN_SELECTED_COLOR : STATUS_BEEN_COLOR;
+        case STATUS_LIVED:
+            return isSelected ? STATUS_LIVED_SELECTED_COLOR : STATUS_LIVED_COLOR;
+        case STATUS_WANT:
+            return isSelected ? STATUS_WANT_SELECTED_COLOR : STATUS_WANT_COLOR;
+        case STATUS_NONE:
+        default:
+            return isSelected ? STATUS_NONE_SELECTED_COLOR : STATUS_NONE_COLOR;
+    }
+}
+
+static void drawPolygons(WorldMap* map, int selectedCountry, CountryStatusList* statusList, bool fill, Rectangle area) {
+    PROF_BEGIN(PROF_CULLING);
+
+    // Calculate visible coordinate ranges
+    float leftLon = screenXToLongitude(area.x, map->zoom, map->offset.x);
+    float rightLon = screenXToLongitude(area.x + area.width, map->zoom, map->offset.x);
+    float topLat = screenYToLatitude(area.y, map->zoom, map->offset.y);
+    float bottomLat = screenYToLatitude(area.y + area.height, map->zoom, map->offset.y);
+
+    Rectangle view = { leftLon, bottomLat, rightLon - leftLon, topLat - bottomLat };
+    int visibleCount = querySpatialGrid(map->spatialIndex, view, map->visiblePolygons);
+    const MapLevel* level = &map->levels[selectMapLevel(map, map->zoom)];
+    MapCamera camera = getMapCamera(map->zoom, map->offset);
+    Vector2* screenPoints = map->screenPoints;
+
+    PROF_END(PROF_CULLING);
+
+    // Fills first and outlines in a second pass, so borders stay on top of
+    // neighbouring fills and each pass can be timed on its own
+    if (fill) {
+        PROF_BEGIN(PROF_FILL);
+        for (int v = 0; v < visibleCount; v++) {
+            int i = map->visiblePolygons[v];
+            const Polygon* poly = &level->polygons[i];
+            if (poly->numPoints == 0) continue;
+
+            projectPoints(camera, getLevelPoints(level, i), screenPoints, poly->numPoints);
+
+            int owner = map->polygonCountry[i];
+            int status = GetCountryStatusByKey(statusList, map->countries[owner].isoKey);
+            Color drawColor = getCountryColor(status, owner == selectedCountry);
+
+            // Fill polygon from the triangles built at load time
+            const int* triangles = getLevelTriangles(level, i);
+            for (int t = 0; t < poly->numTriangles; t++) {
+                const int* tri = &triangles[t * 3];
+                DrawTriangle(screenPoints[tri[0]], screenPoints[tri[1]], screenPoints[tri[2]], drawColor);
             }
         }
+        PROF_END(PROF_FILL);
+    }
+
+    PROF_BEGIN(PROF_OUTLINE);
+    for (int v = 0; v < visibleCount; v++) {
+        int i = map->visiblePolygons[v];
+        const Polygon* poly = &level->polygons[i];
+        if (poly->numPoints == 0) continue;
+
+        projectPoints(camera, getLevelPoints(level, i), screenPoints, poly->numPoints);
 
-        // Draw outline
         for (int j = 0; j < poly->numPoints - 1; j++) {
             DrawLineV(screenPoints[j], screenPoints[j + 1], BLACK);
         }
         DrawLineV(screenPoints[poly->numPoints - 1], screenPoints[0], BLACK);
+    }
+    PROF_END(PROF_OUTLINE);
+}
+
+void drawWorldMap(WorldMap* map, int selectedCountry, CountryStatusList* statusList) {
+    drawPolygons(map, selectedCountry, statusList, true, (Rectangle){ 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT });
+}
+
+void drawWorldMapOutlines(WorldMap* map) {
+    drawPolygons(map, -1, NULL, false, (Rectangle){ 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT });
+}
+
+void drawWorldMapArea(WorldMap* map, int selectedCountry, CountryStatusList* statusList, Rectangle area) {
+    drawPolygons(map, selectedCountry, statusList, true, area);
+}
+
+void drawWorldMapCountry(WorldMap* map, int countryIndex, CountryStatusList* statusList) {
+    if (countryIndex < 0 || countryIndex >= map->countryCount) return;
+
+    float leftLon = screenXToLongitude(0, map->zoom, map->offset.x);
+    float rightLon = screenXToLongitude(SCREEN_WIDTH, map->zoom, map->offset.x);
+    float topLat = screenYToLatitude(0, map->zoom, map->offset.y);
+    float bottomLat = screenYToLatitude(SCREEN_HEIGHT, map->zoom, map->offset.y);
+    Rectangle view = { leftLon, bottomLat, rightLon - leftLon, topLat - bottomLat };
+
+    const MapLevel* level = &map->levels[selectMapLevel(map, map->zoom)];
+    MapCamera camera = getMapCamera(map->zoom, map->offset);
+    Vector2* screenPoints = map->screenPoints;
+    int status = GetCountryStatusByKey(statusList, map->countries[countryIndex].isoKey);
+    Color fillColor = getCountryColor(status, true);
+
+    // A country's polygons need not be contiguous, so pick them by owner
+    // from the polygons in view
+    int visibleCount = querySpatialGrid(map->spatialIndex, view, map->visiblePolygons);
+    for (int v = 0; v < visibleCount; v++) {
+        int i = map->visiblePolygons[v];
+        const Polygon* poly = &level->polygons[i];
+        if (map->polygonCountry[i] != countryIndex || poly->numPoints == 0) continue;
+
+        projectPoints(camera, getLevelPoints(level, i), screenPoints, poly->numPoints);
+
+        const int* triangles = getLevelTriangles(level, i);
+        for (int t = 0; t < poly->numTriangles; t++) {
+            const int* tri = &triangles[t * 3];
+            DrawTriangle(screenPoints[tri[0]], screenPoints[tri[1]], screenPoints[tri[2]], fillColor);
+        }
+        for (int j = 0; j < poly->numPoints; j++) {
+            DrawLineEx(screenPoints[j], screenPoints[(j + 1) % poly->numPoints], 2.0f, SELECTED_OUTLINE_COLOR);
+        }
+    }
+}
+
+Rectangle getCountryBounds(const WorldMap* map, int countryIndex) {
+    if (countryIndex < 0 || countryIndex >= map->countryCount) return (Rectangle){ 0 };
 
-        free(screenPoints);
+    // Features merged by name leave a country's polygons scattered, so go by
+    // owner rather than the country's polygon range
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (int i = 0; i < map->numPolygons; i++) {
+        if (map->polygonCountry[i] != countryIndex || map->polygons[i].numPoints == 0) continue;
+        Rectangle b = map->polygonBounds[i].bounds;
+        minX = fminf(minX, b.x);
+        minY = fminf(minY, b.y);
+        maxX = fmaxf(maxX, b.x + b.width);
+        maxY = fmaxf(maxY, b.y + b.height);
     }
+    if (minX > maxX) return (Rectangle){ 0 };
+    return (Rectangle){ minX, minY, maxX - minX, maxY - minY };
 }
+
 void unloadWorldMap(WorldMap* map) {
     if (map) {
-        for (int i = 0; i < map->numPolygons; i++) {
-            free(map->polygons[i].points);
+        // Geometry lives either in the compiled map file or in the arena
+        if (map->mappedFile) {
+            unmapWorldMapFile(map);
+        } else {
+            arenaFree(&map->arena);
         }
-        for (int i = 0; i < map->countryCount; i++) {
-            if (map->flags[i].loaded) {
-                UnloadTexture(map->flags[i].texture);
-            }
-            free(map->countries[i].polygonPoints);
+        free(map->screenPoints);
+        free(map->visiblePolygons);
+        unloadSpatialGrid(map->spatialIndex);
+        for (int k = 0; k < MAP_LOD_LEVELS; k++) {
+            unloadMapPicker(map->pickers[k]);
         }
-        free(map->countries);
-        free(map->polygons);
-        free(map->polygonBounds);
-        free(map->flags);
         free(map);
     }
 }
 
 
 
-void SaveCountryStatuses(const char* filename, CountryStatusList* list) {
-    FILE* file = fopen(filename, "wb");
-    if (!file) return;
-    
-    fwrite(&list->count, sizeof(int), 1, file);
-    fwrite(list->statuses, sizeof(CountryStatus), list->count, file);
-    fclose(file);
-}
-CountryStatusList* LoadCountryStatuses(const char* filename) {
-    CountryStatusList* list = (CountryStatusList*)malloc(sizeof(CountryStatusList));
-    list->count = 0;
-    list->statuses = NULL;
-    
-    FILE* file = fopen(filename, "rb");
-    if (!file) return list;
-    
-    size_t read = fread(&list->count, sizeof(int), 1, file);
-    if (read != 1) {
-        fclose(file);
-        return list;
-    }
-    
-    list->statuses = (CountryStatus*)malloc(sizeof(CountryStatus) * list->count);
-    read = fread(list->statuses, sizeof(CountryStatus), list->count, file);
-    if (read != list->count) {
-        free(list->statuses);
-        list->statuses = NULL;
-        list->count = 0;
-    }
-    
-    fclose(file);
-    return list;
+int isoCodeKey(const char* iso_code) {
+    if (!iso_code) return -1;
+    int a = tolower((unsigned char)iso_code[0]);
+    int b = a ? tolower((unsigned char)iso_code[1]) : 0;
+    if (a < 'a' || a > 'z' || b < 'a' || b > 'z' || iso_code[2] != '\0') return -1;
+    return (a - 'a') * 26 + (b - 'a');
 }
 
-
+// Codes that are not two letters have no key; the map cannot show a status
+// for them, so they are not stored either
 void UpdateCountryStatus(CountryStatusList* list, const char* iso_code, int status) {
-    // Find existing entry
-    for (int i = 0; i < list->count; i++) {
-        if (strcmp(list->statuses[i].iso_code, iso_code) == 0) {
-            list->statuses[i].status = status;
-            return;
-        }
+    int key = isoCodeKey(iso_code);
+    if (key < 0) return;
+    list->version++;
+    list->statusByKey[key] = (unsigned char)status;
+
+    int entry = list->entryByKey[key] - 1;
+    if (entry < 0) {
+        CountryStatus* grown = (CountryStatus*)realloc(list->statuses, sizeof(CountryStatus) * (list->count + 1));
+        if (!grown) return;
+        list->statuses = grown;
+        entry = list->count++;
+        list->entryByKey[key] = (short)(entry + 1);
+        list->statuses[entry].iso_code[0] = (char)('a' + key / 26);
+        list->statuses[entry].iso_code[1] = (char)('a' + key % 26);
+        list->statuses[entry].iso_code[2] = '\0';
     }
-    
-    // Add new entry
-    list->count++;
-    list->statuses = (CountryStatus*)realloc(list->statuses, sizeof(CountryStatus) * list->count);
-    strncpy(list->statuses[list->count-1].iso_code, iso_code, 3);
-    list->statuses[list->count-1].status = status;
+    list->statuses[entry].status = status;
+}
+
+int GetCountryStatusByKey(const CountryStatusList* list, int isoKey) {
+    if (!list || isoKey < 0 || isoKey >= ISO_KEY_COUNT) return STATUS_NONE;
+    return list->statusByKey[isoKey];
 }
 
 int GetCountryStatus(CountryStatusList* list, const char* iso_code) {
-    for (int i = 0; i < list->count; i++) {
-        if (strcmp(list->statuses[i].iso_code, iso_code) == 0) {
-            return list->statuses[i].status;
-        }
-    }
-    return STATUS_NONE;
-}
\ No newline at end of file
+    return GetCountryStatusByKey(list, isoCodeKey(iso_code));
+}
@@ -0,0 +1,137 @@
+#include "picking.h"
+#include "spatial_index.h"
+#include "map_lod.h"
+#include <stdlib.h>
+#include <math.h>
+
+static int bucketCountFor(const Polygon* poly) {
+    int count = poly->numPoints / PICK_POINTS_PER_BUCKET;
+    if (count < 1) count = 1;
+    if (count > PICK_MAX_BUCKETS) count = PICK_MAX_BUCKETS;
+    return count;
+}
+
+static int bucketFor(float lat, Rectangle bounds, int bucketCount) {
+    if (bounds.height <= 0.0f) return 0;
+    int b = (int)((lat - bounds.y) / bounds.height * bucketCount);
+    if (b < 0) return 0;
+    if (b >= bucketCount) return bucketCount - 1;
+    return b;
+}
+
+MapPicker* buildMapPicker(const WorldMap* map, const MapLevel* level) {
+    MapPicker* picker = (MapPicker*)calloc(1, sizeof(MapPicker));
+    if (!picker) return NULL;
+
+    int numPolygons = map->numPolygons;
+    picker->polygonFirstBucket = (int*)malloc((numPolygons + 1) * sizeof(int));
+    picker->candidates = (int*)malloc((numPolygons > 0 ? numPolygons : 1) * sizeof(int));
+
+    int totalBuckets = 0;
+    for (int i = 0; i < numPolygons; i++) {
+        picker->polygonFirstBucket[i] = totalBuckets;
+        totalBuckets += bucketCountFor(&level->polygons[i]);
+    }
+    picker->polygonFirstBucket[numPolygons] = totalBuckets;
+
+    // Count edges per bucket, then prefix-sum into offsets and fill
+    picker->bucketStart = (int*)calloc(totalBuckets + 1, sizeof(int));
+    for (int i = 0; i < numPolygons; i++) {
+        const Polygon* poly = &level->polygons[i];
+        const Vector2* points = getLevelPoints(level, i);
+        Rectangle bounds = map->polygonBounds[i].bounds;
+        int bucketCount = bucketCountFor(poly);
+        int* counts = &picker->bucketStart[picker->polygonFirstBucket[i] + 1];
+
+        for (int j = 0; j < poly->numPoints; j++) {
+            int k = (j + 1) % poly->numPoints;
+            int b0 = bucketFor(fminf(points[j].y, points[k].y), bounds, bucketCount);
+            int b1 = bucketFor(fmaxf(points[j].y, points[k].y), bounds, bucketCount);
+            for (int b = b0; b <= b1; b++) counts[b]++;
+        }
+    }
+    for (int b = 0; b < totalBuckets; b++) {
+        picker->bucketStart[b + 1] += picker->bucketStart[b];
+    }
+
+    picker->bucketEdges = (int*)malloc((picker->bucketStart[totalBuckets] > 0 ? picker->bucketStart[totalBuckets] : 1) * sizeof(int));
+    int* fill = (int*)malloc((totalBuckets > 0 ? totalBuckets : 1) * sizeof(int));
+    for (int b = 0; b < totalBuckets; b++) fill[b] = picker->bucketStart[b];
+
+    for (int i = 0; i < numPolygons; i++) {
+        const Polygon* poly = &level->polygons[i];
+        const Vector2* points = getLevelPoints(level, i);
+        Rectangle bounds = map->polygonBounds[i].bounds;
+        int bucketCount = bucketCountFor(poly);
+        int first = picker->polygonFirstBucket[i];
+
+        for (int j = 0; j < poly->numPoints; j++) {
+            int k = (j + 1) % poly->numPoints;
+            int b0 = bucketFor(fminf(points[j].y, points[k].y), bounds, bucketCount);
+            int b1 = bucketFor(fmaxf(points[j].y, points[k].y), bounds, bucketCount);
+            for (int b = b0; b <= b1; b++) picker->bucketEdges[fill[first + b]++] = j;
+        }
+    }
+
+    free(fill);
+    return picker;
+}
+
+void unloadMapPicker(MapPicker* picker) {
+    if (!picker) return;
+    free(picker->polygonFirstBucket);
+    free(picker->bucketStart);
+    free(picker->bucketEdges);
+    free(picker->candidates);
+    free(picker);
+}
+
+static bool polygonContains(const MapPicker* picker, const WorldMap* map, const MapLevel* level,
+                            int index, float lon, float lat) {
+    const Polygon* poly = &level->polygons[index];
+    const Vector2* points = getLevelPoints(level, index);
+    int first = picker->polygonFirstBucket[index];
+    int bucketCount = picker->polygonFirstBucket[index + 1] - first;
+    int b = first + bucketFor(lat, map->polygonBounds[index].bounds, bucketCount);
+
+    // Even-odd crossing test over the edges in this latitude band only
+    bool inside = false;
+    for (int e = picker->bucketStart[b]; e < picker->bucketStart[b + 1]; e++) {
+        int j = picker->bucketEdges[e];
+        int k = (j + 1) % poly->numPoints;
+        Vector2 p1 = points[j];
+        Vector2 p2 = points[k];
+
+        if ((p1.y > lat) != (p2.y > lat)) {
+            float x = p1.x + (lat - p1.y) * (p2.x - p1.x) / (p2.y - p1.y);
+            if (lon < x) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+int pickPolygon(WorldMap* map, float lon, float lat) {
+    // Hit-test the outline that is on screen, so clicks match what is drawn
+    int levelIndex = selectMapLevel(map, map->zoom);
+    const MapLevel* level = &map->levels[levelIndex];
+    MapPicker* picker = map->pickers[levelIndex];
+    if (!picker) return -1;
+
+    Rectangle point = { lon, lat, 0.0f, 0.0f };
+    int candidateCount = querySpatialGrid(map->spatialIndex, point, picker->candidates);
+
+    for (int c = 0; c < candidateCount; c++) {
+        int i = picker->candidates[c];
+        if (level->polygons[i].numPoints < 3) continue;
+        if (polygonContains(picker, map, level, i, lon, lat)) return i;
+    }
+    return -1;
+}
+
+int pickCountryAt(WorldMap* map, Vector2 screenPos) {
+    float lon = screenXToLongitude(screenPos.x, map->zoom, map->offset.x);
+    float lat = screenYToLatitude(screenPos.y, map->zoom, map->offset.y);
+
+    int polygon = pickPolygon(map, lon, lat);
+    return polygon >= 0 ? map->polygonCountry[polygon] : -1;
+}
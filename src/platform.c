@@ -0,0 +1,77 @@
+#include "platform.h"
+#include <time.h>
+
+#ifdef PLATFORM_WEB
+#include <emscripten.h>
+
+void mountPersistentStorage(void) {
+    EM_ASM({
+        Module.persistReady = false;
+        FS.mkdir(UTF8ToString($0));
+        FS.mount(IDBFS, {}, UTF8ToString($0));
+        FS.syncfs(true, function(err) {
+            if (err) console.warn("Could not load saved data:", err);
+            Module.persistReady = true;
+        });
+    }, PERSIST_DIR);
+
+    // ASYNCIFY lets the browser run the IndexedDB callbacks meanwhile
+    while (!EM_ASM_INT({ return Module.persistReady ? 1 : 0; })) {
+        emscripten_sleep(5);
+    }
+}
+
+void syncPersistentStorage(void) {
+    EM_ASM({
+        FS.syncfs(false, function(err) {
+            if (err) console.warn("Could not save data:", err);
+        });
+    });
+}
+
+void markStartup(void) {
+}
+
+double getStartupMilliseconds(void) {
+    return emscripten_performance_now();
+}
+
+// Resource Timing counts the page, the bundle and every fetch since
+double getTransferredBytes(void) {
+    return EM_ASM_DOUBLE({
+        var total = 0;
+        var entries = performance.getEntriesByType("navigation").concat(performance.getEntriesByType("resource"));
+        for (var i = 0; i < entries.length; i++) total += entries[i].transferSize || 0;
+        return total;
+    });
+}
+
+#else
+
+static double startupTime;
+
+static double monotonicMilliseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec * 1e-6;
+}
+
+void mountPersistentStorage(void) {
+}
+
+void syncPersistentStorage(void) {
+}
+
+void markStartup(void) {
+    startupTime = monotonicMilliseconds();
+}
+
+double getStartupMilliseconds(void) {
+    return monotonicMilliseconds() - startupTime;
+}
+
+double getTransferredBytes(void) {
+    return -1.0;
+}
+
+#endif
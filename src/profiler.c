@@ -0,0 +1,218 @@
+#include "profiler.h"
+
+#if TT_PROFILE
+#include "raylib.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Ring slot guarded like a seqlock: sequence is index + 1 once the fields are
+// complete, so readers skip slots that are being overwritten
+typedef struct {
+    atomic_uint_fast64_t sequence;
+    atomic_uint_fast64_t start;     // Nanoseconds
+    atomic_uint_fast64_t end;
+    atomic_uint frame;
+    atomic_uint stageAndThread;     // Stage in the low byte, thread above it
+} ProfileSlot;
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    unsigned int frame;
+    int stage;
+    int thread;
+} ProfileEvent;
+
+static ProfileSlot ring[PROFILE_RING_SIZE];
+static atomic_uint_fast64_t writeIndex;
+static atomic_uint currentFrame;
+static atomic_int threadCount;
+static _Thread_local int threadId = -1;
+static double frameStart;
+
+static const char* stageNames[PROF_STAGE_COUNT] = {
+    "frame", "input", "picking", "background", "map layer", "culling", "fill", "outline", "ui", "tiles"
+};
+
+double profileNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+void profileRecord(ProfileStage stage, double start, double end) {
+    if (threadId < 0) threadId = atomic_fetch_add_explicit(&threadCount, 1, memory_order_relaxed);
+
+    uint64_t index = atomic_fetch_add_explicit(&writeIndex, 1, memory_order_relaxed);
+    ProfileSlot* slot = &ring[index & (PROFILE_RING_SIZE - 1)];
+
+    atomic_store_explicit(&slot->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&slot->start, (uint64_t)(start * 1e9), memory_order_relaxed);
+    atomic_store_explicit(&slot->end, (uint64_t)(end * 1e9), memory_order_relaxed);
+    atomic_store_explicit(&slot->frame, atomic_load_explicit(&currentFrame, memory_order_relaxed), memory_order_relaxed);
+    atomic_store_explicit(&slot->stageAndThread, (unsigned int)stage | ((unsigned int)threadId << 8), memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, index + 1, memory_order_release);
+}
+
+static bool readEvent(uint64_t index, ProfileEvent* event) {
+    ProfileSlot* slot = &ring[index & (PROFILE_RING_SIZE - 1)];
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != index + 1) return false;
+
+    event->start = atomic_load_explicit(&slot->start, memory_order_relaxed);
+    event->end = atomic_load_explicit(&slot->end, memory_order_relaxed);
+    event->frame = atomic_load_explicit(&slot->frame, memory_order_relaxed);
+    unsigned int packed = atomic_load_explicit(&slot->stageAndThread, memory_order_relaxed);
+    event->stage = (int)(packed & 0xff);
+    event->thread = (int)(packed >> 8);
+
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->sequence, memory_order_relaxed) == index + 1
+        && event->stage < PROF_STAGE_COUNT;
+}
+
+void profileFrameEnd(void) {
+    double now = profileNow();
+    if (frameStart > 0.0) profileRecord(PROF_FRAME, frameStart, now);
+    frameStart = now;
+    atomic_fetch_add_explicit(&currentFrame, 1, memory_order_relaxed);
+}
+
+// Oldest ring index still holding an event of `firstFrame` or later
+static uint64_t findFirstEvent(unsigned int firstFrame) {
+    uint64_t end = atomic_load_explicit(&writeIndex, memory_order_acquire);
+    uint64_t oldest = end > PROFILE_RING_SIZE ? end - PROFILE_RING_SIZE : 0;
+    uint64_t first = end;
+    while (first > oldest) {
+        ProfileEvent event;
+        if (readEvent(first - 1, &event) && event.frame < firstFrame) break;
+        first--;
+    }
+    return first;
+}
+
+static int compareFloats(const void* a, const void* b) {
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Per-frame stage totals in milliseconds for up to `frames` completed
+// frames, oldest first; the current frame is still running
+static int sumFrames(float (*totals)[PROF_STAGE_COUNT], int frames) {
+    unsigned int frame = atomic_load_explicit(&currentFrame, memory_order_relaxed);
+    int frameCount = frame < (unsigned int)frames ? (int)frame : frames;
+    unsigned int firstFrame = frame - (unsigned int)frameCount;
+
+    memset(totals, 0, sizeof(float) * PROF_STAGE_COUNT * frames);
+    uint64_t end = atomic_load_explicit(&writeIndex, memory_order_acquire);
+    for (uint64_t i = findFirstEvent(firstFrame); i < end; i++) {
+        ProfileEvent event;
+        if (!readEvent(i, &event) || event.frame < firstFrame || event.frame >= frame) continue;
+        totals[event.frame - firstFrame][event.stage] += (float)((event.end - event.start) * 1e-6);
+    }
+    return frameCount;
+}
+
+// p50, p95 and p99 of one stage; sorted is scratch of frameCount floats
+static void stagePercentiles(float (*totals)[PROF_STAGE_COUNT], int frameCount, int stage,
+                             float* sorted, float percentiles[3]) {
+    percentiles[0] = percentiles[1] = percentiles[2] = 0.0f;
+    if (frameCount == 0) return;
+    for (int f = 0; f < frameCount; f++) sorted[f] = totals[f][stage];
+    qsort(sorted, frameCount, sizeof(float), compareFloats);
+    percentiles[0] = sorted[(frameCount - 1) * 50 / 100];
+    percentiles[1] = sorted[(frameCount - 1) * 95 / 100];
+    percentiles[2] = sorted[(frameCount - 1) * 99 / 100];
+}
+
+void drawProfileOverlay(int x, int y) {
+    static float totals[PROFILE_OVERLAY_FRAMES][PROF_STAGE_COUNT];
+    static float sorted[PROFILE_OVERLAY_FRAMES];
+    int frameCount = sumFrames(totals, PROFILE_OVERLAY_FRAMES);
+
+    const int graphHeight = 60;
+    const float graphScale = graphHeight / 33.3f;
+    int width = PROFILE_OVERLAY_FRAMES + 20;
+    int height = graphHeight + 40 + (PROF_STAGE_COUNT + 1) * 14;
+    DrawRectangle(x, y, width, height, Fade(BLACK, 0.75f));
+
+    // Frame-time graph with the 60 Hz budget marked
+    int graphX = x + 10;
+    int graphY = y + 10;
+    for (int f = 0; f < frameCount; f++) {
+        float ms = totals[f][PROF_FRAME];
+        int barHeight = (int)(ms * graphScale);
+        if (barHeight > graphHeight) barHeight = graphHeight;
+        Color color = ms > 33.4f ? RED : (ms > 17.5f ? YELLOW : GREEN);
+        DrawRectangle(graphX + f, graphY + graphHeight - barHeight, 1, barHeight, color);
+    }
+    int budgetY = graphY + graphHeight - (int)(16.7f * graphScale);
+    DrawLine(graphX, budgetY, graphX + PROFILE_OVERLAY_FRAMES, budgetY, Fade(WHITE, 0.5f));
+
+    int textY = graphY + graphHeight + 10;
+    DrawText(TextFormat("%-10s %6s %6s %6s", "ms", "p50", "p95", "p99"), graphX, textY, 10, WHITE);
+    for (int s = 0; s < PROF_STAGE_COUNT; s++) {
+        textY += 14;
+        float p[3];
+        stagePercentiles(totals, frameCount, s, sorted, p);
+        DrawText(TextFormat("%-10s %6.2f %6.2f %6.2f", stageNames[s], p[0], p[1], p[2]), graphX, textY, 10, WHITE);
+    }
+}
+
+void printProfileSummary(const char* label) {
+    static float totals[PROFILE_TRACE_FRAMES][PROF_STAGE_COUNT];
+    static float sorted[PROFILE_TRACE_FRAMES];
+    int frameCount = sumFrames(totals, PROFILE_TRACE_FRAMES);
+
+    printf("Profile %s, last %d frames\n", label, frameCount);
+    printf("  %-10s %7s %7s %7s\n", "ms", "p50", "p95", "p99");
+    for (int s = 0; s < PROF_STAGE_COUNT; s++) {
+        float p[3];
+        stagePercentiles(totals, frameCount, s, sorted, p);
+        printf("  %-10s %7.2f %7.2f %7.2f\n", stageNames[s], p[0], p[1], p[2]);
+    }
+}
+
+bool exportProfileTrace(const char* filename, int frames) {
+    unsigned int frame = atomic_load_explicit(&currentFrame, memory_order_relaxed);
+    unsigned int firstFrame = frame > (unsigned int)frames ? frame - (unsigned int)frames : 0;
+    uint64_t first = findFirstEvent(firstFrame);
+    uint64_t end = atomic_load_explicit(&writeIndex, memory_order_acquire);
+
+    FILE* file = fopen(filename, "w");
+    if (!file) return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int threads = atomic_load_explicit(&threadCount, memory_order_relaxed);
+    for (int t = 0; t < threads; t++) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                t > 0 ? ",\n" : "", t, t);
+    }
+
+    bool firstEvent = threads == 0;
+    uint64_t origin = 0;
+    for (uint64_t i = first; i < end; i++) {
+        ProfileEvent event;
+        if (!readEvent(i, &event) || event.frame < firstFrame) continue;
+        if (origin == 0 || event.start < origin) origin = event.start;
+    }
+    for (uint64_t i = first; i < end; i++) {
+        ProfileEvent event;
+        if (!readEvent(i, &event) || event.frame < firstFrame) continue;
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"traveltint\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                      "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                firstEvent ? "" : ",\n", stageNames[event.stage], event.thread,
+                (double)(event.start - origin) * 1e-3, (double)(event.end - event.start) * 1e-3, event.frame);
+        firstEvent = false;
+    }
+    fprintf(file, "\n]}\n");
+
+    return fclose(file) == 0;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include "projection.h"
+#include "map_utils.h"
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PROJECTION_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+typedef void (*ProjectFn)(MapCamera camera, const Vector2* in, Vector2* out, int count);
+
+static const char* kernelNames[PROJECTION_KERNEL_COUNT] = { "auto", "scalar", "sse2", "avx2", "simd128" };
+
+MapCamera getMapCamera(float zoom, Vector2 offset) {
+    float scaleX = (SCREEN_WIDTH / 360.0f) * zoom;
+    float scaleY = (SCREEN_HEIGHT / 180.0f) * zoom;
+    return (MapCamera){
+        { scaleX, -scaleY },
+        { 180.0f * scaleX + offset.x, 90.0f * scaleY + offset.y }
+    };
+}
+
+MapCamera invertMapCamera(MapCamera camera) {
+    return (MapCamera){
+        { 1.0f / camera.scale.x, 1.0f / camera.scale.y },
+        { -camera.translate.x / camera.scale.x, -camera.translate.y / camera.scale.y }
+    };
+}
+
+static void projectScalar(MapCamera camera, const Vector2* in, Vector2* out, int count) {
+    for (int i = 0; i < count; i++) {
+        out[i].x = in[i].x * camera.scale.x + camera.translate.x;
+        out[i].y = in[i].y * camera.scale.y + camera.translate.y;
+    }
+}
+
+#ifdef PROJECTION_X86
+// Vector2 arrays are interleaved x, y, so a register holds whole points and
+// the camera is broadcast as (sx, sy, sx, sy, ...)
+static void projectSSE2(MapCamera camera, const Vector2* in, Vector2* out, int count) {
+    __m128 scale = _mm_setr_ps(camera.scale.x, camera.scale.y, camera.scale.x, camera.scale.y);
+    __m128 translate = _mm_setr_ps(camera.translate.x, camera.translate.y, camera.translate.x, camera.translate.y);
+    const float* src = (const float*)in;
+    float* dst = (float*)out;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(src + i * 2);
+        __m128 b = _mm_loadu_ps(src + i * 2 + 4);
+        _mm_storeu_ps(dst + i * 2, _mm_add_ps(_mm_mul_ps(a, scale), translate));
+        _mm_storeu_ps(dst + i * 2 + 4, _mm_add_ps(_mm_mul_ps(b, scale), translate));
+    }
+    projectScalar(camera, in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2,fma")))
+static void projectAVX2(MapCamera camera, const Vector2* in, Vector2* out, int count) {
+    __m256 scale = _mm256_setr_ps(camera.scale.x, camera.scale.y, camera.scale.x, camera.scale.y,
+                                  camera.scale.x, camera.scale.y, camera.scale.x, camera.scale.y);
+    __m256 translate = _mm256_setr_ps(camera.translate.x, camera.translate.y, camera.translate.x, camera.translate.y,
+                                      camera.translate.x, camera.translate.y, camera.translate.x, camera.translate.y);
+    const float* src = (const float*)in;
+    float* dst = (float*)out;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 a = _mm256_loadu_ps(src + i * 2);
+        __m256 b = _mm256_loadu_ps(src + i * 2 + 8);
+        _mm256_storeu_ps(dst + i * 2, _mm256_fmadd_ps(a, scale, translate));
+        _mm256_storeu_ps(dst + i * 2 + 8, _mm256_fmadd_ps(b, scale, translate));
+    }
+    projectScalar(camera, in + i, out + i, count - i);
+}
+#endif
+
+#ifdef __wasm_simd128__
+static void projectSIMD128(MapCamera camera, const Vector2* in, Vector2* out, int count) {
+    v128_t scale = wasm_f32x4_make(camera.scale.x, camera.scale.y, camera.scale.x, camera.scale.y);
+    v128_t translate = wasm_f32x4_make(camera.translate.x, camera.translate.y, camera.translate.x, camera.translate.y);
+    const float* src = (const float*)in;
+    float* dst = (float*)out;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        v128_t a = wasm_v128_load(src + i * 2);
+        v128_t b = wasm_v128_load(src + i * 2 + 4);
+        wasm_v128_store(dst + i * 2, wasm_f32x4_add(wasm_f32x4_mul(a, scale), translate));
+        wasm_v128_store(dst + i * 2 + 4, wasm_f32x4_add(wasm_f32x4_mul(b, scale), translate));
+    }
+    projectScalar(camera, in + i, out + i, count - i);
+}
+#endif
+
+static ProjectFn kernelFunction(ProjectionKernel kernel) {
+    switch (kernel) {
+        case PROJECTION_KERNEL_SCALAR:
+            return projectScalar;
+#ifdef PROJECTION_X86
+        case PROJECTION_KERNEL_SSE2:
+            return __builtin_cpu_supports("sse2") ? projectSSE2 : NULL;
+        case PROJECTION_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ? projectAVX2 : NULL;
+#endif
+#ifdef __wasm_simd128__
+        case PROJECTION_KERNEL_SIMD128:
+            return projectSIMD128;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+static ProjectionKernel bestKernel(void) {
+    const ProjectionKernel order[] = {
+        PROJECTION_KERNEL_AVX2, PROJECTION_KERNEL_SIMD128, PROJECTION_KERNEL_SSE2
+    };
+    for (int i = 0; i < (int)(sizeof(order) / sizeof(order[0])); i++) {
+        if (kernelFunction(order[i])) return order[i];
+    }
+    return PROJECTION_KERNEL_SCALAR;
+}
+
+// Resolved on first use; any thread may race to it with the same answer
+static _Atomic(ProjectFn) activeFunction;
+static _Atomic(ProjectionKernel) activeKernel;
+
+bool setProjectionKernel(ProjectionKernel kernel) {
+    if (kernel == PROJECTION_KERNEL_AUTO) kernel = bestKernel();
+    ProjectFn fn = kernelFunction(kernel);
+    if (!fn) return false;
+    atomic_store(&activeKernel, kernel);
+    atomic_store(&activeFunction, fn);
+    return true;
+}
+
+ProjectionKernel getProjectionKernel(void) {
+    if (!atomic_load(&activeFunction)) setProjectionKernel(PROJECTION_KERNEL_AUTO);
+    return atomic_load(&activeKernel);
+}
+
+const char* getProjectionKernelName(ProjectionKernel kernel) {
+    if ((int)kernel < 0 || kernel >= PROJECTION_KERNEL_COUNT) return "unknown";
+    return kernelNames[kernel];
+}
+
+void projectPoints(MapCamera camera, const Vector2* in, Vector2* out, int count) {
+    ProjectFn fn = atomic_load_explicit(&activeFunction, memory_order_acquire);
+    if (!fn) {
+        setProjectionKernel(PROJECTION_KERNEL_AUTO);
+        fn = atomic_load(&activeFunction);
+    }
+    fn(camera, in, out, count);
+}
@@ -0,0 +1,511 @@
+#include "raster.h"
+#include "map_lod.h"
+#include "projection.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RASTER_POLYGONS_PER_TASK 64
+#define RASTER_MAX_SIZE 16384
+
+typedef struct {
+    float xTop;
+    float yTop;
+    float yBottom;
+    float slope;        // dx/dy
+    float x;            // At the current sub-scanline
+} RasterEdge;
+
+typedef struct {
+    float coverage[RASTER_TILE_SIZE + 1];
+    RasterEdge* edges;  // Edge table of the polygon being filled, sorted by top
+    int* active;        // Indices into edges, kept sorted by x
+    int edgeCapacity;
+} RasterScratch;
+
+// The pixels one tile may touch
+typedef struct {
+    Color* pixels;
+    int stride;
+    int x0, y0, x1, y1;
+} RasterTile;
+
+struct RasterContext {
+    const WorldMap* map;
+    int workers;
+    RasterScratch* scratch;
+
+    Vector2* screenPoints;      // Indexed like the level's points
+    int screenCapacity;
+    Rectangle* screenBounds;    // Per polygon, in pixels
+    unsigned char* visible;
+    int* binStart;              // Per tile, into binPolygons
+    int* binPolygons;
+    int tileCapacity;
+    int binCapacity;
+
+    // Current render
+    const MapLevel* level;
+    const CountryStatusList* statuses;
+    MapCamera camera;
+    bool transparent;
+    Image* image;
+    int tilesX;
+    int tilesY;
+};
+
+RasterContext* createRasterContext(const WorldMap* map, int workers) {
+    if (!map || workers < 1) return NULL;
+    RasterContext* context = (RasterContext*)calloc(1, sizeof(RasterContext));
+    if (!context) return NULL;
+
+    context->map = map;
+    context->workers = workers;
+    context->scratch = (RasterScratch*)calloc(workers, sizeof(RasterScratch));
+    context->screenBounds = (Rectangle*)malloc(sizeof(Rectangle) * (map->numPolygons + 1));
+    context->visible = (unsigned char*)malloc(map->numPolygons + 1);
+    if (!context->scratch || !context->screenBounds || !context->visible) {
+        destroyRasterContext(context);
+        return NULL;
+    }
+    return context;
+}
+
+void destroyRasterContext(RasterContext* context) {
+    if (!context) return;
+    if (context->scratch) {
+        for (int w = 0; w < context->workers; w++) {
+            free(context->scratch[w].edges);
+            free(context->scratch[w].active);
+        }
+    }
+    free(context->scratch);
+    free(context->screenPoints);
+    free(context->screenBounds);
+    free(context->visible);
+    free(context->binStart);
+    free(context->binPolygons);
+    free(context);
+}
+
+static bool reserveEdges(RasterScratch* scratch, int count) {
+    if (count <= scratch->edgeCapacity) return true;
+    int capacity = scratch->edgeCapacity ? scratch->edgeCapacity : 256;
+    while (capacity < count) capacity *= 2;
+
+    RasterEdge* edges = (RasterEdge*)realloc(scratch->edges, sizeof(RasterEdge) * capacity);
+    if (!edges) return false;
+    scratch->edges = edges;
+    int* active = (int*)realloc(scratch->active, sizeof(int) * capacity);
+    if (!active) return false;
+    scratch->active = active;
+    scratch->edgeCapacity = capacity;
+    return true;
+}
+
+static int compareEdgeTops(const void* a, const void* b) {
+    float x = ((const RasterEdge*)a)->yTop;
+    float y = ((const RasterEdge*)b)->yTop;
+    return (x > y) - (x < y);
+}
+
+// Source-over onto a pixel that may itself be partly transparent
+static void blendPixel(Color* pixel, Color color, float alpha) {
+    if (alpha >= 1.0f) {
+        *pixel = (Color){ color.r, color.g, color.b, 255 };
+        return;
+    }
+    float outAlpha = alpha + pixel->a / 255.0f * (1.0f - alpha);
+    float weight = alpha / outAlpha;
+    pixel->r = (unsigned char)(pixel->r + (color.r - pixel->r) * weight + 0.5f);
+    pixel->g = (unsigned char)(pixel->g + (color.g - pixel->g) * weight + 0.5f);
+    pixel->b = (unsigned char)(pixel->b + (color.b - pixel->b) * weight + 0.5f);
+    pixel->a = (unsigned char)(outAlpha * 255.0f + 0.5f);
+}
+
+// Adds the horizontal coverage of [left, right) at one sub-scanline
+static void addSpan(const RasterTile* tile, float* coverage, float left, float right, float weight,
+                    int* minX, int* maxX) {
+    if (left < tile->x0) left = (float)tile->x0;
+    if (right > tile->x1) right = (float)tile->x1;
+    if (left >= right) return;
+
+    int first = (int)left;
+    int last = (int)right;
+    if (first == last) {
+        coverage[first - tile->x0] += (right - left) * weight;
+    } else {
+        coverage[first - tile->x0] += (first + 1 - left) * weight;
+        for (int x = first + 1; x < last; x++) {
+            coverage[x - tile->x0] += weight;
+        }
+        if (last < tile->x1) coverage[last - tile->x0] += (right - last) * weight;
+    }
+
+    if (first < *minX) *minX = first;
+    if (last > *maxX) *maxX = last < tile->x1 ? last : tile->x1 - 1;
+}
+
+// Even-odd scanline fill of one ring inside the tile: an edge table sorted
+// by top feeds an active list that is re-sorted by x at every sub-scanline
+static void fillPolygon(RasterContext* context, RasterScratch* scratch, const RasterTile* tile, int polygon, Color color) {
+    const Polygon* poly = &context->level->polygons[polygon];
+    const Vector2* points = context->screenPoints + poly->pointStart;
+    int n = poly->numPoints;
+    Rectangle bounds = context->screenBounds[polygon];
+
+    int rowStart = (int)floorf(bounds.y);
+    int rowEnd = (int)ceilf(bounds.y + bounds.height);
+    if (rowStart < tile->y0) rowStart = tile->y0;
+    if (rowEnd > tile->y1) rowEnd = tile->y1;
+    if (n < 3 || rowStart >= rowEnd || !reserveEdges(scratch, n)) return;
+
+    int count = 0;
+    for (int j = 0; j < n; j++) {
+        Vector2 a = points[j];
+        Vector2 b = points[j + 1 < n ? j + 1 : 0];
+        if (a.y == b.y) continue;
+        Vector2 top = a.y < b.y ? a : b;
+        Vector2 bottom = a.y < b.y ? b : a;
+        if (bottom.y <= rowStart || top.y >= rowEnd) continue;
+
+        scratch->edges[count++] = (RasterEdge){
+            top.x, top.y, bottom.y, (bottom.x - top.x) / (bottom.y - top.y), top.x
+        };
+    }
+    if (count < 2) return;
+    qsort(scratch->edges, count, sizeof(RasterEdge), compareEdgeTops);
+
+    RasterEdge* edges = scratch->edges;
+    int* active = scratch->active;
+    int activeCount = 0;
+    int next = 0;
+    const float weight = 1.0f / RASTER_SUBSAMPLES;
+
+    for (int row = rowStart; row < rowEnd; row++) {
+        int minX = tile->x1;
+        int maxX = tile->x0 - 1;
+
+        for (int sub = 0; sub < RASTER_SUBSAMPLES; sub++) {
+            float y = row + (sub + 0.5f) * weight;
+            while (next < count && edges[next].yTop <= y) {
+                active[activeCount++] = next++;
+            }
+
+            // Drop finished edges and step the others to this sub-scanline
+            int kept = 0;
+            for (int i = 0; i < activeCount; i++) {
+                RasterEdge* edge = &edges[active[i]];
+                if (edge->yBottom <= y) continue;
+                edge->x = edge->xTop + (y - edge->yTop) * edge->slope;
+                active[kept++] = active[i];
+            }
+            activeCount = kept;
+
+            // Insertion sort: the order barely changes between sub-scanlines
+            for (int i = 1; i < activeCount; i++) {
+                int edge = active[i];
+                float x = edges[edge].x;
+                int j = i - 1;
+                while (j >= 0 && edges[active[j]].x > x) {
+                    active[j + 1] = active[j];
+                    j--;
+                }
+                active[j + 1] = edge;
+            }
+
+            for (int i = 0; i + 1 < activeCount; i += 2) {
+                addSpan(tile, scratch->coverage, edges[active[i]].x, edges[active[i + 1]].x, weight, &minX, &maxX);
+            }
+        }
+
+        Color* pixels = tile->pixels + (size_t)row * tile->stride;
+        for (int x = minX; x <= maxX; x++) {
+            float coverage = scratch->coverage[x - tile->x0];
+            scratch->coverage[x - tile->x0] = 0.0f;
+            if (coverage > 0.0f) blendPixel(&pixels[x], color, coverage);
+        }
+        if (next >= count && activeCount == 0) break;
+    }
+}
+
+static void plotLinePixel(const RasterTile* tile, bool steep, int x, int y, float alpha, Color color) {
+    if (steep) {
+        int swap = x;
+        x = y;
+        y = swap;
+    }
+    if (x < tile->x0 || x >= tile->x1 || y < tile->y0 || y >= tile->y1 || alpha <= 0.0f) return;
+    blendPixel(&tile->pixels[(size_t)y * tile->stride + x], color, alpha);
+}
+
+// Liang-Barsky clip of a segment against a rectangle
+static bool clipSegment(Vector2* a, Vector2* b, float left, float top, float right, float bottom) {
+    float dx = b->x - a->x;
+    float dy = b->y - a->y;
+    float p[4] = { -dx, dx, -dy, dy };
+    float q[4] = { a->x - left, right - a->x, a->y - top, bottom - a->y };
+    float t0 = 0.0f, t1 = 1.0f;
+
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0.0f) {
+            if (q[i] < 0.0f) return false;
+            continue;
+        }
+        float t = q[i] / p[i];
+        if (p[i] < 0.0f) {
+            if (t > t1) return false;
+            if (t > t0) t0 = t;
+        } else {
+            if (t < t0) return false;
+            if (t < t1) t1 = t;
+        }
+    }
+
+    Vector2 start = *a;
+    *a = (Vector2){ start.x + dx * t0, start.y + dy * t0 };
+    *b = (Vector2){ start.x + dx * t1, start.y + dy * t1 };
+    return true;
+}
+
+static float fractionalPart(float value) {
+    return value - floorf(value);
+}
+
+// Xiaolin Wu's anti-aliased line. The segment is clipped to the tile plus a
+// margin first, so the ends it cuts off fall outside the tile.
+static void drawLineWu(const RasterTile* tile, Vector2 a, Vector2 b, Color color) {
+    if (!clipSegment(&a, &b, tile->x0 - 2.0f, tile->y0 - 2.0f, tile->x1 + 2.0f, tile->y1 + 2.0f)) return;
+
+    // Pixel centers at integer coordinates
+    float ax = a.x - 0.5f, ay = a.y - 0.5f;
+    float bx = b.x - 0.5f, by = b.y - 0.5f;
+    bool steep = fabsf(by - ay) > fabsf(bx - ax);
+    if (steep) {
+        float swap = ax; ax = ay; ay = swap;
+        swap = bx; bx = by; by = swap;
+    }
+    if (ax > bx) {
+        float swap = ax; ax = bx; bx = swap;
+        swap = ay; ay = by; by = swap;
+    }
+
+    float dx = bx - ax;
+    float gradient = dx == 0.0f ? 1.0f : (by - ay) / dx;
+
+    float xEnd = roundf(ax);
+    float yEnd = ay + gradient * (xEnd - ax);
+    float xGap = 1.0f - fractionalPart(ax + 0.5f);
+    int xStart = (int)xEnd;
+    plotLinePixel(tile, steep, xStart, (int)floorf(yEnd), (1.0f - fractionalPart(yEnd)) * xGap, color);
+    plotLinePixel(tile, steep, xStart, (int)floorf(yEnd) + 1, fractionalPart(yEnd) * xGap, color);
+    float intersectY = yEnd + gradient;
+
+    xEnd = roundf(bx);
+    yEnd = by + gradient * (xEnd - bx);
+    xGap = fractionalPart(bx + 0.5f);
+    int xStop = (int)xEnd;
+    plotLinePixel(tile, steep, xStop, (int)floorf(yEnd), (1.0f - fractionalPart(yEnd)) * xGap, color);
+    plotLinePixel(tile, steep, xStop, (int)floorf(yEnd) + 1, fractionalPart(yEnd) * xGap, color);
+
+    for (int x = xStart + 1; x < xStop; x++) {
+        int y = (int)floorf(intersectY);
+        float f = intersectY - y;
+        plotLinePixel(tile, steep, x, y, 1.0f - f, color);
+        plotLinePixel(tile, steep, x, y + 1, f, color);
+        intersectY += gradient;
+    }
+}
+
+static void strokePolygon(RasterContext* context, const RasterTile* tile, int polygon) {
+    const Polygon* poly = &context->level->polygons[polygon];
+    const Vector2* points = context->screenPoints + poly->pointStart;
+    int n = poly->numPoints;
+
+    for (int j = 0; j < n; j++) {
+        Vector2 a = points[j];
+        Vector2 b = points[j + 1 < n ? j + 1 : 0];
+        if (fmaxf(a.x, b.x) < tile->x0 - 1 || fminf(a.x, b.x) > tile->x1 + 1 ||
+            fmaxf(a.y, b.y) < tile->y0 - 1 || fminf(a.y, b.y) > tile->y1 + 1) continue;
+        drawLineWu(tile, a, b, BLACK);
+    }
+}
+
+static void cullProjectTask(void* data, int index, int worker) {
+    (void)worker;
+    RasterContext* context = (RasterContext*)data;
+    const WorldMap* map = context->map;
+    MapCamera camera = context->camera;
+    float width = (float)context->image->width;
+    float height = (float)context->image->height;
+
+    int end = (index + 1) * RASTER_POLYGONS_PER_TASK;
+    if (end > map->numPolygons) end = map->numPolygons;
+    for (int i = index * RASTER_POLYGONS_PER_TASK; i < end; i++) {
+        const Polygon* poly = &context->level->polygons[i];
+        Rectangle b = map->polygonBounds[i].bounds;
+
+        // Lat grows upwards, pixels downwards; one pixel of margin for borders
+        float left = b.x * camera.scale.x + camera.translate.x - 1.0f;
+        float right = (b.x + b.width) * camera.scale.x + camera.translate.x + 1.0f;
+        float top = (b.y + b.height) * camera.scale.y + camera.translate.y - 1.0f;
+        float bottom = b.y * camera.scale.y + camera.translate.y + 1.0f;
+        context->screenBounds[i] = (Rectangle){ left, top, right - left, bottom - top };
+
+        bool visible = poly->numPoints >= 2 && right > 0.0f && left < width && bottom > 0.0f && top < height;
+        context->visible[i] = visible;
+        if (visible) {
+            projectPoints(camera, getLevelPoints(context->level, i), context->screenPoints + poly->pointStart, poly->numPoints);
+        }
+    }
+}
+
+static void tileRange(const RasterContext* context, Rectangle bounds, int* tx0, int* ty0, int* tx1, int* ty1) {
+    *tx0 = (int)floorf(bounds.x / RASTER_TILE_SIZE);
+    *ty0 = (int)floorf(bounds.y / RASTER_TILE_SIZE);
+    *tx1 = (int)floorf((bounds.x + bounds.width) / RASTER_TILE_SIZE);
+    *ty1 = (int)floorf((bounds.y + bounds.height) / RASTER_TILE_SIZE);
+    if (*tx0 < 0) *tx0 = 0;
+    if (*ty0 < 0) *ty0 = 0;
+    if (*tx1 >= context->tilesX) *tx1 = context->tilesX - 1;
+    if (*ty1 >= context->tilesY) *ty1 = context->tilesY - 1;
+}
+
+// Lists, per tile and in drawing order, the visible polygons overlapping it
+static bool binPolygons(RasterContext* context) {
+    const WorldMap* map = context->map;
+    int tiles = context->tilesX * context->tilesY;
+    if (tiles + 1 > context->tileCapacity) {
+        int* binStart = (int*)realloc(context->binStart, sizeof(int) * (tiles + 1));
+        if (!binStart) return false;
+        context->binStart = binStart;
+        context->tileCapacity = tiles + 1;
+    }
+    memset(context->binStart, 0, sizeof(int) * (tiles + 1));
+
+    for (int i = 0; i < map->numPolygons; i++) {
+        if (!context->visible[i]) continue;
+        int tx0, ty0, tx1, ty1;
+        tileRange(context, context->screenBounds[i], &tx0, &ty0, &tx1, &ty1);
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                context->binStart[ty * context->tilesX + tx + 1]++;
+            }
+        }
+    }
+    for (int t = 0; t < tiles; t++) {
+        context->binStart[t + 1] += context->binStart[t];
+    }
+
+    int total = context->binStart[tiles];
+    if (total > context->binCapacity) {
+        int* binPolygons = (int*)realloc(context->binPolygons, sizeof(int) * total);
+        if (!binPolygons) return false;
+        context->binPolygons = binPolygons;
+        context->binCapacity = total;
+    }
+
+    // Fill using binStart as a cursor, then shift it back
+    for (int i = 0; i < map->numPolygons; i++) {
+        if (!context->visible[i]) continue;
+        int tx0, ty0, tx1, ty1;
+        tileRange(context, context->screenBounds[i], &tx0, &ty0, &tx1, &ty1);
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                context->binPolygons[context->binStart[ty * context->tilesX + tx]++] = i;
+            }
+        }
+    }
+    for (int t = tiles; t > 0; t--) {
+        context->binStart[t] = context->binStart[t - 1];
+    }
+    context->binStart[0] = 0;
+    return true;
+}
+
+static void rasterTileTask(void* data, int index, int worker) {
+    RasterContext* context = (RasterContext*)data;
+    RasterScratch* scratch = &context->scratch[worker];
+    const WorldMap* map = context->map;
+    Image* image = context->image;
+
+    RasterTile tile;
+    tile.pixels = (Color*)image->data;
+    tile.stride = image->width;
+    tile.x0 = (index % context->tilesX) * RASTER_TILE_SIZE;
+    tile.y0 = (index / context->tilesX) * RASTER_TILE_SIZE;
+    tile.x1 = tile.x0 + RASTER_TILE_SIZE < image->width ? tile.x0 + RASTER_TILE_SIZE : image->width;
+    tile.y1 = tile.y0 + RASTER_TILE_SIZE < image->height ? tile.y0 + RASTER_TILE_SIZE : image->height;
+
+    Color background = context->transparent ? BLANK : SPACE_BG_COLOR;
+    for (int y = tile.y0; y < tile.y1; y++) {
+        Color* row = tile.pixels + (size_t)y * tile.stride;
+        for (int x = tile.x0; x < tile.x1; x++) {
+            row[x] = background;
+        }
+    }
+
+    const int* bin = context->binPolygons + context->binStart[index];
+    int binCount = context->binStart[index + 1] - context->binStart[index];
+    for (int b = 0; b < binCount; b++) {
+        int polygon = bin[b];
+        int owner = map->polygonCountry[polygon];
+        int status = GetCountryStatusByKey(context->statuses, map->countries[owner].isoKey);
+        fillPolygon(context, scratch, &tile, polygon, getCountryColor(status, false));
+    }
+
+    // Borders go over every fill, as in the window
+    for (int b = 0; b < binCount; b++) {
+        strokePolygon(context, &tile, bin[b]);
+    }
+}
+
+bool renderMapImage(RasterContext* context, const CountryStatusList* statuses, RasterView view,
+                    ThreadPool* pool, Image* image) {
+    if (!context || !image || view.width <= 0 || view.height <= 0 ||
+        view.width > RASTER_MAX_SIZE || view.height > RASTER_MAX_SIZE || view.zoom <= 0.0f) return false;
+    if (getThreadPoolSize(pool) > context->workers) return false;
+    const WorldMap* map = context->map;
+
+    // Same degrees per pixel on each axis as the window, scaled to the width
+    float scaleX = view.width / 360.0f * view.zoom;
+    float scaleY = scaleX * ((SCREEN_HEIGHT / 180.0f) / (SCREEN_WIDTH / 360.0f));
+    context->camera = (MapCamera){
+        { scaleX, -scaleY },
+        { view.width * 0.5f - view.center.x * scaleX, view.height * 0.5f + view.center.y * scaleY }
+    };
+    context->level = &map->levels[selectMapLevelForScale(map, 1.0f / scaleX)];
+    context->statuses = statuses;
+    context->transparent = view.transparent;
+
+    if (context->level->numPoints > context->screenCapacity) {
+        Vector2* screenPoints = (Vector2*)realloc(context->screenPoints, sizeof(Vector2) * context->level->numPoints);
+        if (!screenPoints) return false;
+        context->screenPoints = screenPoints;
+        context->screenCapacity = context->level->numPoints;
+    }
+
+    *image = (Image){
+        .data = malloc((size_t)view.width * view.height * sizeof(Color)),
+        .width = view.width,
+        .height = view.height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+    };
+    if (!image->data) return false;
+    context->image = image;
+    context->tilesX = (view.width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    context->tilesY = (view.height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+
+    int blocks = (map->numPolygons + RASTER_POLYGONS_PER_TASK - 1) / RASTER_POLYGONS_PER_TASK;
+    parallelFor(pool, blocks, cullProjectTask, context);
+    if (!binPolygons(context)) {
+        free(image->data);
+        image->data = NULL;
+        return false;
+    }
+    parallelFor(pool, context->tilesX * context->tilesY, rasterTileTask, context);
+
+    context->image = NULL;
+    return true;
+}
@@ -0,0 +1,314 @@
+#include "render_cli.h"
+#include "raster.h"
+#include "status_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RENDER_DEFAULT_MAP "assets/world.geojson"
+#define BATCH_LINE_LENGTH 2048
+
+typedef struct {
+    const char* output;
+    const char* manifestPath;
+    const char* statusPath;
+    const char* mapPath;
+    RasterView view;
+} RenderOptions;
+
+static double secondsNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void printUsage(const char* program) {
+    int indent = (int)strlen(program);
+    printf("Usage: %s --render out.png [--status file.dat] [--center lon,lat] [--zoom z]\n"
+           "       %*s [--size WxH] [--map world.geojson]\n"
+           "       %s --batch manifest.txt [--center lon,lat] [--zoom z] [--size WxH]\n"
+           "       %*s [--map world.geojson]\n"
+           "Each manifest line is \"status.dat out.png\"; blank lines and # comments are skipped.\n",
+           program, indent, "", program, indent, "");
+}
+
+static bool parseOptions(int argc, char** argv, RenderOptions* options) {
+    *options = (RenderOptions){
+        .mapPath = RENDER_DEFAULT_MAP,
+        .view = { SCREEN_WIDTH, SCREEN_HEIGHT, { 0.0f, 0.0f }, 1.0f }
+    };
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!value) return false;
+        i++;
+
+        if (strcmp(arg, "--render") == 0) {
+            options->output = value;
+        } else if (strcmp(arg, "--batch") == 0) {
+            options->manifestPath = value;
+        } else if (strcmp(arg, "--status") == 0) {
+            options->statusPath = value;
+        } else if (strcmp(arg, "--map") == 0) {
+            options->mapPath = value;
+        } else if (strcmp(arg, "--center") == 0) {
+            if (sscanf(value, "%f,%f", &options->view.center.x, &options->view.center.y) != 2) return false;
+        } else if (strcmp(arg, "--zoom") == 0) {
+            options->view.zoom = strtof(value, NULL);
+            if (options->view.zoom <= 0.0f) return false;
+        } else if (strcmp(arg, "--size") == 0) {
+            if (sscanf(value, "%dx%d", &options->view.width, &options->view.height) != 2) return false;
+            if (options->view.width <= 0 || options->view.height <= 0) return false;
+        } else {
+            return false;
+        }
+    }
+    // Exactly one of a single image or a batch
+    return (options->output != NULL) != (options->manifestPath != NULL);
+}
+
+bool isRenderCommand(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--render") == 0 || strcmp(argv[i], "--batch") == 0) return true;
+    }
+    return false;
+}
+
+typedef struct {
+    char* statusPath;
+    char* outputPath;
+} BatchJob;
+
+// Everything one worker touches while rendering; only its own thread writes
+// to it, so workers never share mutable state.
+typedef struct {
+    RasterContext* context;
+    double decodeTime;
+    double renderTime;
+    double encodeTime;
+    double writeTime;
+    int rendered;
+    int failed;
+} BatchWorker;
+
+typedef struct {
+    const WorldMap* map;
+    RasterView view;
+    const BatchJob* jobs;
+    BatchWorker* workers;
+} Batch;
+
+static char* copyString(const char* text) {
+    size_t length = strlen(text) + 1;
+    char* copy = malloc(length);
+    if (copy) memcpy(copy, text, length);
+    return copy;
+}
+
+static void freeBatchJobs(BatchJob* jobs, int count) {
+    for (int i = 0; i < count; i++) {
+        free(jobs[i].statusPath);
+        free(jobs[i].outputPath);
+    }
+    free(jobs);
+}
+
+static BatchJob* loadBatchManifest(const char* filename, int* count) {
+    *count = 0;
+    FILE* file = fopen(filename, "r");
+    if (!file) return NULL;
+
+    BatchJob* jobs = NULL;
+    int capacity = 0;
+    char line[BATCH_LINE_LENGTH];
+    char statusPath[BATCH_LINE_LENGTH];
+    char outputPath[BATCH_LINE_LENGTH];
+    int lineNumber = 0;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char* text = line + strspn(line, " \t\r\n");
+        if (*text == '\0' || *text == '#') continue;
+
+        if (sscanf(text, "%2047s %2047s", statusPath, outputPath) != 2) {
+            printf("%s:%d: expected \"status.dat out.png\"\n", filename, lineNumber);
+            ok = false;
+            break;
+        }
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            BatchJob* grown = realloc(jobs, capacity * sizeof(BatchJob));
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            jobs = grown;
+        }
+        BatchJob* job = &jobs[(*count)++];
+        job->statusPath = copyString(statusPath);
+        job->outputPath = copyString(outputPath);
+        ok = job->statusPath && job->outputPath;
+    }
+    fclose(file);
+
+    if (!ok) {
+        freeBatchJobs(jobs, *count);
+        *count = 0;
+        return NULL;
+    }
+    return jobs;
+}
+
+// Decodes, rasterizes and encodes one profile start to finish. Jobs are
+// handed out one at a time as workers free up, so while one worker is
+// blocked reading a status file or writing a PNG the others keep
+// rasterizing and the three stages stay overlapped across the pool.
+static void renderBatchTask(void* context, int index, int worker) {
+    Batch* batch = context;
+    const BatchJob* job = &batch->jobs[index];
+    BatchWorker* state = &batch->workers[worker];
+
+    double start = secondsNow();
+    CountryStatusList* statuses = LoadCountryStatuses(job->statusPath);
+    double decoded = secondsNow();
+
+    Image image = { 0 };
+    bool ok = statuses && renderMapImage(state->context, statuses, batch->view, NULL, &image);
+    double rendered = secondsNow();
+
+    int size = 0;
+    unsigned char* png = ok ? ExportImageToMemory(image, ".png", &size) : NULL;
+    double encoded = secondsNow();
+
+    ok = png && SaveFileData(job->outputPath, png, size);
+    double written = secondsNow();
+
+    state->decodeTime += decoded - start;
+    state->renderTime += rendered - decoded;
+    state->encodeTime += encoded - rendered;
+    state->writeTime += written - encoded;
+    if (ok) {
+        state->rendered++;
+    } else {
+        state->failed++;
+        printf("Failed to render %s -> %s\n", job->statusPath, job->outputPath);
+    }
+
+    if (png) MemFree(png);
+    if (image.data) UnloadImage(image);
+    if (statuses) free(statuses->statuses);
+    free(statuses);
+}
+
+static int runBatchCommand(const RenderOptions* options) {
+    int jobCount = 0;
+    BatchJob* jobs = loadBatchManifest(options->manifestPath, &jobCount);
+    if (!jobs) {
+        printf("Failed to read manifest: %s\n", options->manifestPath);
+        return 1;
+    }
+
+    double start = secondsNow();
+    WorldMap* map = loadWorldMap(options->mapPath);
+    if (!map) {
+        printf("Failed to load map: %s\n", options->mapPath);
+        freeBatchJobs(jobs, jobCount);
+        return 1;
+    }
+    double loaded = secondsNow();
+
+    // Each worker renders whole images on its own, so every context is
+    // single-threaded and the map is only ever read.
+    ThreadPool* pool = createThreadPool(0);
+    int workerCount = getThreadPoolSize(pool);
+    BatchWorker* workers = calloc(workerCount, sizeof(BatchWorker));
+    bool ok = workers != NULL;
+    for (int i = 0; ok && i < workerCount; i++) {
+        workers[i].context = createRasterContext(map, 1);
+        ok = workers[i].context != NULL;
+    }
+
+    Batch batch = { map, options->view, jobs, workers };
+    if (ok) parallelFor(pool, jobCount, renderBatchTask, &batch);
+    double finished = secondsNow();
+
+    BatchWorker total = { 0 };
+    for (int i = 0; workers && i < workerCount; i++) {
+        total.decodeTime += workers[i].decodeTime;
+        total.renderTime += workers[i].renderTime;
+        total.encodeTime += workers[i].encodeTime;
+        total.writeTime += workers[i].writeTime;
+        total.rendered += workers[i].rendered;
+        total.failed += workers[i].failed;
+        destroyRasterContext(workers[i].context);
+    }
+
+    if (ok) {
+        double elapsed = finished - loaded;
+        int images = total.rendered + total.failed;
+        double perImage = images > 0 ? 1000.0 / images : 0.0;
+        printf("Rendered %d of %d images (%dx%d) in %.2f s on %d threads: %.1f images/s\n",
+               total.rendered, jobCount, options->view.width, options->view.height, elapsed,
+               workerCount, elapsed > 0.0 ? total.rendered / elapsed : 0.0);
+        printf("Map load %.1f ms; per image: decode %.2f ms, render %.2f ms, encode %.2f ms, write %.2f ms\n",
+               (loaded - start) * 1000.0, total.decodeTime * perImage, total.renderTime * perImage,
+               total.encodeTime * perImage, total.writeTime * perImage);
+    } else {
+        printf("Failed to set up %d batch workers\n", workerCount);
+    }
+
+    free(workers);
+    destroyThreadPool(pool);
+    unloadWorldMap(map);
+    freeBatchJobs(jobs, jobCount);
+    return ok && total.failed == 0 ? 0 : 1;
+}
+
+int runRenderCommand(int argc, char** argv) {
+    RenderOptions options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    if (options.manifestPath) return runBatchCommand(&options);
+
+    double start = secondsNow();
+
+    WorldMap* map = loadWorldMap(options.mapPath);
+    if (!map) {
+        printf("Failed to load map: %s\n", options.mapPath);
+        return 1;
+    }
+    CountryStatusList* statuses = options.statusPath ? LoadCountryStatuses(options.statusPath)
+                                                     : (CountryStatusList*)calloc(1, sizeof(CountryStatusList));
+    double loaded = secondsNow();
+
+    ThreadPool* pool = createThreadPool(0);
+    RasterContext* context = createRasterContext(map, getThreadPoolSize(pool));
+    Image image = { 0 };
+    bool ok = context && statuses && renderMapImage(context, statuses, options.view, pool, &image);
+    double rendered = secondsNow();
+
+    ok = ok && ExportImage(image, options.output);
+    double written = secondsNow();
+    if (ok) {
+        printf("Wrote %s (%dx%d): load %.1f ms, render %.1f ms on %d threads, encode %.1f ms\n",
+               options.output, image.width, image.height, (loaded - start) * 1000.0,
+               (rendered - loaded) * 1000.0, getThreadPoolSize(pool), (written - rendered) * 1000.0);
+    } else {
+        printf("Failed to render %s\n", options.output);
+    }
+
+    if (image.data) UnloadImage(image);
+    destroyRasterContext(context);
+    destroyThreadPool(pool);
+    if (statuses) free(statuses->statuses);
+    free(statuses);
+    unloadWorldMap(map);
+    return ok ? 0 : 1;
+}
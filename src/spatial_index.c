@@ -0,0 +1,108 @@
+#include "spatial_index.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static int clampCell(int value, int max) {
+    if (value < 0) return 0;
+    if (value >= max) return max - 1;
+    return value;
+}
+
+// Cell range covered by a lon/lat rectangle, clamped to the grid
+static void cellRange(const SpatialGrid* grid, Rectangle area, int* x0, int* y0, int* x1, int* y1) {
+    *x0 = clampCell((int)floorf((area.x + 180.0f) / grid->cellSize), grid->cols);
+    *x1 = clampCell((int)floorf((area.x + area.width + 180.0f) / grid->cellSize), grid->cols);
+    *y0 = clampCell((int)floorf((area.y + 90.0f) / grid->cellSize), grid->rows);
+    *y1 = clampCell((int)floorf((area.y + area.height + 90.0f) / grid->cellSize), grid->rows);
+}
+
+SpatialGrid* buildSpatialGrid(const PolygonBounds* bounds, int count) {
+    SpatialGrid* grid = (SpatialGrid*)calloc(1, sizeof(SpatialGrid));
+    if (!grid) return NULL;
+
+    grid->cellSize = SPATIAL_GRID_CELL_DEGREES;
+    grid->cols = (int)ceilf(360.0f / grid->cellSize);
+    grid->rows = (int)ceilf(180.0f / grid->cellSize);
+    grid->bounds = bounds;
+    grid->itemCount = count;
+
+    int cellCount = grid->cols * grid->rows;
+    grid->cellStart = (int*)calloc(cellCount + 1, sizeof(int));
+    grid->visitStamp = (unsigned int*)calloc(count > 0 ? count : 1, sizeof(unsigned int));
+
+    // First pass counts entries per cell, second pass fills them in
+    for (int i = 0; i < count; i++) {
+        int x0, y0, x1, y1;
+        cellRange(grid, bounds[i].bounds, &x0, &y0, &x1, &y1);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                grid->cellStart[y * grid->cols + x + 1]++;
+            }
+        }
+    }
+    for (int c = 0; c < cellCount; c++) {
+        grid->cellStart[c + 1] += grid->cellStart[c];
+    }
+
+    grid->cellItems = (int*)malloc((grid->cellStart[cellCount] > 0 ? grid->cellStart[cellCount] : 1) * sizeof(int));
+    int* fill = (int*)malloc(cellCount * sizeof(int));
+    memcpy(fill, grid->cellStart, cellCount * sizeof(int));
+
+    for (int i = 0; i < count; i++) {
+        int x0, y0, x1, y1;
+        cellRange(grid, bounds[i].bounds, &x0, &y0, &x1, &y1);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                grid->cellItems[fill[y * grid->cols + x]++] = i;
+            }
+        }
+    }
+
+    free(fill);
+    return grid;
+}
+
+void unloadSpatialGrid(SpatialGrid* grid) {
+    if (!grid) return;
+    free(grid->cellStart);
+    free(grid->cellItems);
+    free(grid->visitStamp);
+    free(grid);
+}
+
+int querySpatialGrid(SpatialGrid* grid, Rectangle area, int* results) {
+    if (!grid) return 0;
+
+    // Stamps make repeated polygons across cells cheap to skip; reset on wrap
+    if (++grid->stamp == 0) {
+        memset(grid->visitStamp, 0, grid->itemCount * sizeof(unsigned int));
+        grid->stamp = 1;
+    }
+
+    float areaRight = area.x + area.width;
+    float areaTop = area.y + area.height;
+
+    int x0, y0, x1, y1;
+    cellRange(grid, area, &x0, &y0, &x1, &y1);
+
+    int found = 0;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            int cell = y * grid->cols + x;
+            for (int k = grid->cellStart[cell]; k < grid->cellStart[cell + 1]; k++) {
+                int i = grid->cellItems[k];
+                if (grid->visitStamp[i] == grid->stamp) continue;
+                grid->visitStamp[i] = grid->stamp;
+
+                Rectangle b = grid->bounds[i].bounds;
+                if (b.x + b.width < area.x || b.x > areaRight ||
+                    b.y + b.height < area.y || b.y > areaTop) continue;
+
+                results[found++] = i;
+            }
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,389 @@
+#include "status_store.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef TT_THREADS
+#include <pthread.h>
+#endif
+
+#define STATUS_JOURNAL_HEADER_SIZE 8
+#define STATUS_JOURNAL_RECORD_SIZE 8
+#define STATUS_ENTRY_SIZE 4
+
+typedef struct {
+    char iso_code[3];
+    unsigned char status;
+} StatusRecord;
+
+struct StatusJournal {
+    char path[512];         // Snapshot path; the journal adds STATUS_JOURNAL_EXTENSION
+    char journalPath[512];
+    FILE* file;             // Open for appending, NULL until the first record
+    int journalRecords;     // Records on disk since the last snapshot
+    CountryStatusList* state;   // Writer's own copy, so compaction never reads the UI's
+
+#ifdef TT_THREADS
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stopping;
+#endif
+    StatusRecord* pending;  // Queued by appendStatusJournal
+    int pendingCount;
+    int pendingCapacity;
+    bool flushed;           // Records reached the file since takeStatusJournalFlush
+};
+
+static uint32_t fnv1a(const unsigned char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void putU32(unsigned char* out, uint32_t value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t getU32(const unsigned char* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static void getJournalPath(const char* filename, char* out, size_t outSize) {
+    snprintf(out, outSize, "%s%s", filename, STATUS_JOURNAL_EXTENSION);
+}
+
+static bool readLegacyStatuses(FILE* file, CountryStatusList* list) {
+    int count = 0;
+    if (fread(&count, sizeof(int), 1, file) != 1 || count < 0) return false;
+
+    CountryStatus* statuses = (CountryStatus*)malloc(sizeof(CountryStatus) * (count > 0 ? count : 1));
+    if (!statuses) return false;
+    if (fread(statuses, sizeof(CountryStatus), count, file) != (size_t)count) {
+        free(statuses);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        statuses[i].iso_code[2] = '\0';
+        UpdateCountryStatus(list, statuses[i].iso_code, statuses[i].status);
+    }
+    free(statuses);
+    return true;
+}
+
+static bool readSnapshot(FILE* file, CountryStatusList* list) {
+    unsigned char header[sizeof(StatusFileHeader)];
+    if (fread(header, 4, 1, file) != 1) return false;
+    if (memcmp(header, STATUS_FILE_MAGIC, 4) != 0) {
+        // No magic: the unversioned format written before snapshots existed
+        rewind(file);
+        return readLegacyStatuses(file, list);
+    }
+    if (fread(header + 4, sizeof(header) - 4, 1, file) != 1) return false;
+
+    uint32_t version = getU32(header + 4);
+    uint32_t count = getU32(header + 8);
+    uint32_t checksum = getU32(header + 12);
+    if (version != STATUS_FILE_VERSION || count > ISO_KEY_COUNT * 4) {
+        printf("Warning: Unsupported status file version %u\n", version);
+        return false;
+    }
+
+    unsigned char* entries = (unsigned char*)malloc((size_t)count * STATUS_ENTRY_SIZE + 1);
+    if (!entries) return false;
+    bool ok = fread(entries, STATUS_ENTRY_SIZE, count, file) == count &&
+              fnv1a(entries, (size_t)count * STATUS_ENTRY_SIZE) == checksum;
+    if (ok) {
+        for (uint32_t i = 0; i < count; i++) {
+            const unsigned char* entry = entries + i * STATUS_ENTRY_SIZE;
+            char iso_code[3] = { (char)entry[0], (char)entry[1], '\0' };
+            UpdateCountryStatus(list, iso_code, entry[2]);
+        }
+    } else {
+        printf("Warning: Status snapshot is damaged, ignoring it\n");
+    }
+    free(entries);
+    return ok;
+}
+
+// Applies the journal to list (when given) and returns the length of its
+// intact prefix, or 0 when there is no usable journal
+static long replayJournal(const char* journalPath, CountryStatusList* list) {
+    FILE* file = fopen(journalPath, "rb");
+    if (!file) return 0;
+
+    unsigned char header[STATUS_JOURNAL_HEADER_SIZE];
+    if (fread(header, sizeof(header), 1, file) != 1 || memcmp(header, STATUS_JOURNAL_MAGIC, 4) != 0 ||
+        getU32(header + 4) != STATUS_JOURNAL_VERSION) {
+        fclose(file);
+        return 0;
+    }
+
+    long valid = STATUS_JOURNAL_HEADER_SIZE;
+    unsigned char record[STATUS_JOURNAL_RECORD_SIZE];
+    while (fread(record, sizeof(record), 1, file) == 1) {
+        if (fnv1a(record, 4) != getU32(record + 4)) break;   // Torn or damaged tail
+        if (list) {
+            char iso_code[3] = { (char)record[0], (char)record[1], '\0' };
+            UpdateCountryStatus(list, iso_code, record[2]);
+        }
+        valid += STATUS_JOURNAL_RECORD_SIZE;
+    }
+    fclose(file);
+    return valid;
+}
+
+CountryStatusList* LoadCountryStatuses(const char* filename) {
+    CountryStatusList* list = (CountryStatusList*)calloc(1, sizeof(CountryStatusList));
+    if (!list) return NULL;
+
+    FILE* file = fopen(filename, "rb");
+    if (file) {
+        readSnapshot(file, list);
+        fclose(file);
+    }
+
+    char journalPath[512];
+    getJournalPath(filename, journalPath, sizeof(journalPath));
+    replayJournal(journalPath, list);
+
+    list->version = 0;
+    return list;
+}
+
+static bool writeSnapshot(const char* filename, const CountryStatusList* list) {
+    size_t entriesSize = (size_t)list->count * STATUS_ENTRY_SIZE;
+    unsigned char* entries = (unsigned char*)calloc(1, entriesSize + 1);
+    if (!entries) return false;
+    for (int i = 0; i < list->count; i++) {
+        unsigned char* entry = entries + (size_t)i * STATUS_ENTRY_SIZE;
+        entry[0] = (unsigned char)list->statuses[i].iso_code[0];
+        entry[1] = (unsigned char)list->statuses[i].iso_code[1];
+        entry[2] = (unsigned char)list->statuses[i].status;
+    }
+
+    unsigned char header[sizeof(StatusFileHeader)];
+    memcpy(header, STATUS_FILE_MAGIC, 4);
+    putU32(header + 4, STATUS_FILE_VERSION);
+    putU32(header + 8, (uint32_t)list->count);
+    putU32(header + 12, fnv1a(entries, entriesSize));
+
+    char tempPath[520];
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", filename);
+    FILE* file = fopen(tempPath, "wb");
+    bool ok = file != NULL;
+    if (ok) {
+        ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+             fwrite(entries, 1, entriesSize, file) == entriesSize &&
+             fflush(file) == 0 && fsync(fileno(file)) == 0;
+        ok = fclose(file) == 0 && ok;
+    }
+    free(entries);
+
+    // The rename is what replaces the old snapshot, so a crash before it
+    // leaves the previous snapshot and journal untouched
+    if (ok) ok = rename(tempPath, filename) == 0;
+    if (!ok) {
+        printf("Warning: Could not write %s\n", filename);
+        remove(tempPath);
+    }
+    return ok;
+}
+
+void SaveCountryStatuses(const char* filename, CountryStatusList* list) {
+    if (!writeSnapshot(filename, list)) return;
+    char journalPath[512];
+    getJournalPath(filename, journalPath, sizeof(journalPath));
+    remove(journalPath);
+}
+
+static void compactJournal(StatusJournal* journal) {
+    if (!writeSnapshot(journal->path, journal->state)) return;
+    if (journal->file) {
+        fclose(journal->file);
+        journal->file = NULL;
+    }
+    remove(journal->journalPath);
+    journal->journalRecords = 0;
+}
+
+// Runs on the writer thread (or inline without threads)
+static void writeRecords(StatusJournal* journal, const StatusRecord* records, int count) {
+    if (!journal->file) {
+        journal->file = fopen(journal->journalPath, "ab");
+        if (!journal->file) {
+            printf("Warning: Could not open %s\n", journal->journalPath);
+            return;
+        }
+        // The position of a stream opened for appending is unspecified
+        // until the first write, so look at the end explicitly
+        fseek(journal->file, 0, SEEK_END);
+        if (ftell(journal->file) == 0) {
+            unsigned char header[STATUS_JOURNAL_HEADER_SIZE];
+            memcpy(header, STATUS_JOURNAL_MAGIC, 4);
+            putU32(header + 4, STATUS_JOURNAL_VERSION);
+            fwrite(header, sizeof(header), 1, journal->file);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        unsigned char record[STATUS_JOURNAL_RECORD_SIZE];
+        record[0] = (unsigned char)records[i].iso_code[0];
+        record[1] = (unsigned char)records[i].iso_code[1];
+        record[2] = records[i].status;
+        record[3] = 0;
+        putU32(record + 4, fnv1a(record, 4));
+        fwrite(record, sizeof(record), 1, journal->file);
+        UpdateCountryStatus(journal->state, records[i].iso_code, records[i].status);
+    }
+    fflush(journal->file);
+    fsync(fileno(journal->file));
+
+    journal->journalRecords += count;
+    if (journal->journalRecords >= STATUS_JOURNAL_COMPACT_RECORDS) compactJournal(journal);
+}
+
+#ifdef TT_THREADS
+static void* writerMain(void* arg) {
+    StatusJournal* journal = (StatusJournal*)arg;
+    StatusRecord* batch = NULL;
+    int batchCapacity = 0;
+
+    pthread_mutex_lock(&journal->lock);
+    for (;;) {
+        while (!journal->stopping && journal->pendingCount == 0) {
+            pthread_cond_wait(&journal->wake, &journal->lock);
+        }
+        if (journal->pendingCount == 0) break;
+
+        // Swap the queue out so appends never wait on the disk
+        StatusRecord* records = journal->pending;
+        int count = journal->pendingCount;
+        int capacity = journal->pendingCapacity;
+        journal->pending = batch;
+        journal->pendingCapacity = batchCapacity;
+        journal->pendingCount = 0;
+        batch = records;
+        batchCapacity = capacity;
+        pthread_mutex_unlock(&journal->lock);
+
+        writeRecords(journal, records, count);
+
+        pthread_mutex_lock(&journal->lock);
+        journal->flushed = true;
+    }
+    pthread_mutex_unlock(&journal->lock);
+    free(batch);
+    return NULL;
+}
+#endif
+
+StatusJournal* openStatusJournal(const char* filename, const CountryStatusList* list) {
+    StatusJournal* journal = (StatusJournal*)calloc(1, sizeof(StatusJournal));
+    if (!journal) return NULL;
+    snprintf(journal->path, sizeof(journal->path), "%s", filename);
+    getJournalPath(filename, journal->journalPath, sizeof(journal->journalPath));
+
+    journal->state = (CountryStatusList*)calloc(1, sizeof(CountryStatusList));
+    if (!journal->state) {
+        free(journal);
+        return NULL;
+    }
+    for (int i = 0; i < list->count; i++) {
+        UpdateCountryStatus(journal->state, list->statuses[i].iso_code, list->statuses[i].status);
+    }
+
+    // Cut a torn tail off before appending, or replay would stop at it
+    long valid = replayJournal(journal->journalPath, NULL);
+    if (valid > 0) {
+        if (truncate(journal->journalPath, valid) != 0) {
+            remove(journal->journalPath);
+            valid = 0;
+        }
+        journal->journalRecords = (int)((valid - STATUS_JOURNAL_HEADER_SIZE) / STATUS_JOURNAL_RECORD_SIZE);
+    } else {
+        remove(journal->journalPath);
+    }
+
+#ifdef TT_THREADS
+    pthread_mutex_init(&journal->lock, NULL);
+    pthread_cond_init(&journal->wake, NULL);
+    if (pthread_create(&journal->thread, NULL, writerMain, journal) != 0) {
+        pthread_cond_destroy(&journal->wake);
+        pthread_mutex_destroy(&journal->lock);
+        free(journal->state->statuses);
+        free(journal->state);
+        free(journal);
+        return NULL;
+    }
+#endif
+    return journal;
+}
+
+void appendStatusJournal(StatusJournal* journal, const char* iso_code, int status) {
+    if (!journal || !iso_code) return;
+    StatusRecord record = { { iso_code[0], iso_code[0] ? iso_code[1] : '\0', '\0' }, (unsigned char)status };
+
+#ifdef TT_THREADS
+    pthread_mutex_lock(&journal->lock);
+    if (journal->pendingCount == journal->pendingCapacity) {
+        int capacity = journal->pendingCapacity ? journal->pendingCapacity * 2 : 64;
+        StatusRecord* grown = (StatusRecord*)realloc(journal->pending, sizeof(StatusRecord) * capacity);
+        if (!grown) {
+            pthread_mutex_unlock(&journal->lock);
+            return;
+        }
+        journal->pending = grown;
+        journal->pendingCapacity = capacity;
+    }
+    journal->pending[journal->pendingCount++] = record;
+    pthread_cond_signal(&journal->wake);
+    pthread_mutex_unlock(&journal->lock);
+#else
+    writeRecords(journal, &record, 1);
+    journal->flushed = true;
+#endif
+}
+
+bool takeStatusJournalFlush(StatusJournal* journal) {
+    if (!journal) return false;
+#ifdef TT_THREADS
+    pthread_mutex_lock(&journal->lock);
+#endif
+    bool flushed = journal->flushed;
+    journal->flushed = false;
+#ifdef TT_THREADS
+    pthread_mutex_unlock(&journal->lock);
+#endif
+    return flushed;
+}
+
+void closeStatusJournal(StatusJournal* journal) {
+    if (!journal) return;
+
+#ifdef TT_THREADS
+    pthread_mutex_lock(&journal->lock);
+    journal->stopping = true;
+    pthread_cond_signal(&journal->wake);
+    pthread_mutex_unlock(&journal->lock);
+    pthread_join(journal->thread, NULL);
+    pthread_cond_destroy(&journal->wake);
+    pthread_mutex_destroy(&journal->lock);
+#endif
+
+    if (journal->journalRecords > 0) compactJournal(journal);
+    if (journal->file) fclose(journal->file);
+
+    free(journal->pending);
+    free(journal->state->statuses);
+    free(journal->state);
+    free(journal);
+}
@@ -0,0 +1,172 @@
+#include "thread_pool.h"
+#include <stdlib.h>
+
+#ifdef TT_THREADS
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define THREAD_POOL_MAX_THREADS 64
+
+struct ThreadPool {
+    pthread_t* threads;
+    int threadCount;            // Including the thread that calls parallelFor
+    pthread_mutex_t lock;
+    pthread_cond_t jobReady;
+    pthread_cond_t jobDone;
+    unsigned int generation;    // Bumped for every job, workers wait on it
+    int busyWorkers;
+    bool stopping;
+
+    // Current job
+    ParallelTask task;
+    void* context;
+    int count;
+    atomic_int next;
+};
+
+typedef struct {
+    ThreadPool* pool;
+    int worker;
+} WorkerStart;
+
+static void runItems(ThreadPool* pool, int worker) {
+    for (;;) {
+        int index = atomic_fetch_add_explicit(&pool->next, 1, memory_order_relaxed);
+        if (index >= pool->count) break;
+        pool->task(pool->context, index, worker);
+    }
+}
+
+static void* workerMain(void* arg) {
+    WorkerStart start = *(WorkerStart*)arg;
+    free(arg);
+    ThreadPool* pool = start.pool;
+
+    unsigned int seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->jobReady, &pool->lock);
+        }
+        if (pool->stopping) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        runItems(pool, start.worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busyWorkers == 0) pthread_cond_signal(&pool->jobDone);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static int defaultThreadCount(void) {
+    const char* env = getenv(THREAD_POOL_ENV);
+    int count = env ? atoi(env) : 0;
+    if (count <= 0) count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    return count;
+}
+
+ThreadPool* createThreadPool(int threadCount) {
+    if (threadCount <= 0) threadCount = defaultThreadCount();
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > THREAD_POOL_MAX_THREADS) threadCount = THREAD_POOL_MAX_THREADS;
+
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+    pool->threadCount = 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->jobReady, NULL);
+    pthread_cond_init(&pool->jobDone, NULL);
+    atomic_init(&pool->next, 0);
+
+    pool->threads = (pthread_t*)calloc(threadCount, sizeof(pthread_t));
+    for (int i = 1; pool->threads && i < threadCount; i++) {
+        WorkerStart* start = (WorkerStart*)malloc(sizeof(WorkerStart));
+        if (!start) break;
+        *start = (WorkerStart){ pool, i };
+        if (pthread_create(&pool->threads[i], NULL, workerMain, start) != 0) {
+            free(start);
+            break;
+        }
+        pool->threadCount++;
+    }
+    return pool;
+}
+
+void destroyThreadPool(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->jobReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->threadCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->jobDone);
+    pthread_cond_destroy(&pool->jobReady);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+int getThreadPoolSize(const ThreadPool* pool) {
+    return pool ? pool->threadCount : 1;
+}
+
+void parallelFor(ThreadPool* pool, int count, ParallelTask task, void* context) {
+    if (count <= 0) return;
+    if (!pool || pool->threadCount == 1 || count == 1) {
+        for (int i = 0; i < count; i++) task(context, i, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->context = context;
+    pool->count = count;
+    atomic_store(&pool->next, 0);
+    pool->busyWorkers = pool->threadCount - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->jobReady);
+    pthread_mutex_unlock(&pool->lock);
+
+    runItems(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busyWorkers > 0) {
+        pthread_cond_wait(&pool->jobDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+#else
+
+struct ThreadPool {
+    int threadCount;
+};
+
+ThreadPool* createThreadPool(int threadCount) {
+    (void)threadCount;
+    return NULL;
+}
+
+void destroyThreadPool(ThreadPool* pool) {
+    (void)pool;
+}
+
+int getThreadPoolSize(const ThreadPool* pool) {
+    (void)pool;
+    return 1;
+}
+
+void parallelFor(ThreadPool* pool, int count, ParallelTask task, void* context) {
+    (void)pool;
+    for (int i = 0; i < count; i++) task(context, i, 0);
+}
+
+#endif
@@ -0,0 +1,104 @@
+#include "triangulate.h"
+#include <stdbool.h>
+#include <math.h>
+
+static float cross(Vector2 a, Vector2 b, Vector2 c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+static bool pointInTriangle(Vector2 p, Vector2 a, Vector2 b, Vector2 c) {
+    // Triangle is CCW, so p is inside when it is left of (or on) every edge
+    return cross(a, b, p) >= 0.0f && cross(b, c, p) >= 0.0f && cross(c, a, p) >= 0.0f;
+}
+
+static bool samePoint(Vector2 a, Vector2 b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+int triangulatePolygon(const Vector2* points, int numPoints, int* indices, int* scratch) {
+    int n = numPoints;
+    while (n > 1 && samePoint(points[n - 1], points[0])) n--;
+    if (n < 3) return 0;
+
+    int* prev = scratch;
+    int* next = scratch + n;
+
+    // Work out the ring orientation so ears can be tested as CCW triangles
+    float area = 0.0f;
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+        area += (points[j].x - points[i].x) * (points[j].y + points[i].y);
+    }
+    bool ccw = area > 0.0f;
+
+    // Build the vertex ring in CCW order, dropping repeated points
+    int first = -1, last = -1, remaining = 0;
+    for (int k = 0; k < n; k++) {
+        int i = ccw ? k : n - 1 - k;
+        if (last >= 0 && samePoint(points[i], points[last])) continue;
+        if (last >= 0) {
+            next[last] = i;
+            prev[i] = last;
+        } else {
+            first = i;
+        }
+        last = i;
+        remaining++;
+    }
+    if (remaining > 1 && samePoint(points[last], points[first])) {
+        last = prev[last];
+        remaining--;
+    }
+    if (remaining < 3) return 0;
+    next[last] = first;
+    prev[first] = last;
+
+    int triangleCount = 0;
+    int v = first;
+    int stalled = 0;
+
+    while (remaining > 3) {
+        int a = prev[v], c = next[v];
+        Vector2 pa = points[a], pv = points[v], pc = points[c];
+        bool isEar = cross(pa, pv, pc) > 0.0f;
+
+        if (isEar) {
+            float minX = fminf(pa.x, fminf(pv.x, pc.x)), maxX = fmaxf(pa.x, fmaxf(pv.x, pc.x));
+            float minY = fminf(pa.y, fminf(pv.y, pc.y)), maxY = fmaxf(pa.y, fmaxf(pv.y, pc.y));
+
+            for (int p = next[c]; p != a; p = next[p]) {
+                Vector2 pp = points[p];
+                if (pp.x < minX || pp.x > maxX || pp.y < minY || pp.y > maxY) continue;
+                if (samePoint(pp, pa) || samePoint(pp, pv) || samePoint(pp, pc)) continue;
+                if (pointInTriangle(pp, pa, pv, pc)) {
+                    isEar = false;
+                    break;
+                }
+            }
+        }
+
+        // A full lap without an ear means the ring is degenerate or
+        // self-intersecting; clip anyway so the loop always terminates.
+        if (isEar || stalled > remaining) {
+            indices[triangleCount * 3 + 0] = a;
+            indices[triangleCount * 3 + 1] = v;
+            indices[triangleCount * 3 + 2] = c;
+            triangleCount++;
+
+            next[a] = c;
+            prev[c] = a;
+            remaining--;
+            stalled = 0;
+            v = a;
+        } else {
+            stalled++;
+            v = c;
+        }
+    }
+
+    indices[triangleCount * 3 + 0] = prev[v];
+    indices[triangleCount * 3 + 1] = v;
+    indices[triangleCount * 3 + 2] = next[v];
+    triangleCount++;
+
+    return triangleCount;
+}
@@ -0,0 +1,593 @@
+// Benchmarks map loading, startup, culling, projection, picking and status
+// lookups without a window, and optionally drawing with --gl. Results are
+// written as JSON.
+// Usage: bench [--out results.json] [--samples N] [--work dir] [--gl]
+//              [--dataset small|large|path.geojson]...
+#include "map_utils.h"
+#include "map_file.h"
+#include "map_lod.h"
+#include "spatial_index.h"
+#include "picking.h"
+#include "projection.h"
+#include "raster.h"
+#include "status_store.h"
+#include "thread_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#define BENCH_MAX_DATASETS 8
+#define BENCH_MAX_SAMPLES 4096
+#define BENCH_PATH_FRAMES 240
+#define BENCH_PICKS_PER_FRAME 64
+
+// Allocation counting: the bench binary links with --wrap for these, so
+// every call made by the map code lands here first
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+static atomic_size_t allocCount;
+static atomic_size_t allocBytes;
+
+void* __wrap_malloc(size_t size) {
+    atomic_fetch_add_explicit(&allocCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocBytes, size, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    atomic_fetch_add_explicit(&allocCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocBytes, count * size, memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    atomic_fetch_add_explicit(&allocCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocBytes, size, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+typedef struct {
+    const char* name;
+    char path[512];
+    int cols;               // Generated grid of countries, 0 for a file on disk
+    int rows;
+    int edgeSteps;          // Points along each country border
+} Dataset;
+
+typedef struct {
+    double samples[BENCH_MAX_SAMPLES];
+    int count;
+    size_t allocs;
+    size_t bytes;
+    double start;
+    size_t startAllocs;
+    size_t startBytes;
+} Timer;
+
+typedef struct {
+    FILE* out;
+    bool first;
+} Report;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void timerStart(Timer* timer) {
+    timer->startAllocs = atomic_load(&allocCount);
+    timer->startBytes = atomic_load(&allocBytes);
+    timer->start = now();
+}
+
+static void timerStop(Timer* timer) {
+    double elapsed = now() - timer->start;
+    if (timer->count < BENCH_MAX_SAMPLES) timer->samples[timer->count++] = elapsed * 1000.0;
+    timer->allocs += atomic_load(&allocCount) - timer->startAllocs;
+    timer->bytes += atomic_load(&allocBytes) - timer->startBytes;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double* sorted, int count, double p) {
+    if (count == 0) return 0.0;
+    int index = (int)ceil(p * count) - 1;
+    if (index < 0) index = 0;
+    if (index >= count) index = count - 1;
+    return sorted[index];
+}
+
+// items > 0 adds the throughput of one median sample, in items per nanosecond
+static void reportItems(Report* r, const char* name, const char* dataset, int param, Timer* timer, double items) {
+    qsort(timer->samples, timer->count, sizeof(double), compareDoubles);
+    double median = percentile(timer->samples, timer->count, 0.5);
+    double p95 = percentile(timer->samples, timer->count, 0.95);
+    double perSample = timer->count > 0 ? 1.0 / timer->count : 0.0;
+    double perNs = items > 0 && median > 0 ? items / (median * 1e6) : 0.0;
+
+    fprintf(r->out, "%s\n    { \"name\": \"%s\", \"dataset\": \"%s\", \"param\": %d, \"samples\": %d, "
+                    "\"median_ms\": %.4f, \"p95_ms\": %.4f, \"allocs\": %.1f, \"alloc_bytes\": %.0f",
+            r->first ? "" : ",", name, dataset, param, timer->count, median, p95,
+            timer->allocs * perSample, timer->bytes * perSample);
+    if (items > 0) fprintf(r->out, ", \"items_per_ns\": %.4f", perNs);
+    fprintf(r->out, " }");
+    r->first = false;
+
+    fprintf(stderr, "%-16s %-10s %6d  median %9.3f ms  p95 %9.3f ms  %8.1f allocs",
+            name, dataset, param, median, p95, timer->allocs * perSample);
+    if (items > 0) fprintf(stderr, "  %7.3f items/ns", perNs);
+    fprintf(stderr, "\n");
+    memset(timer, 0, sizeof(*timer));
+}
+
+static void report(Report* r, const char* name, const char* dataset, int param, Timer* timer) {
+    reportItems(r, name, dataset, param, timer, 0);
+}
+
+// Deterministic noise so generated worlds are identical between runs
+static unsigned int noiseState;
+
+static float noise(void) {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return (noiseState >> 8) / (float)(1u << 24) - 0.5f;
+}
+
+// Border between two grid corners, jagged unless it is on the outer frame.
+// Every border is generated from its own seed so neighbours share it exactly.
+static void writeBorder(FILE* file, float x0, float y0, float x1, float y1, int steps, bool jagged,
+                        unsigned int seed, bool reverse, bool* first) {
+    noiseState = seed;
+    float dx = x1 - x0, dy = y1 - y0;
+    float length = sqrtf(dx * dx + dy * dy);
+    float nx = -dy / length, ny = dx / length;
+    float amplitude = length / steps * 2.0f;
+
+    float* offsets = (float*)malloc((steps + 1) * sizeof(float));
+    float walk = 0.0f;
+    for (int s = 0; s <= steps; s++) {
+        walk = jagged && s > 0 && s < steps ? walk * 0.9f + noise() * amplitude : 0.0f;
+        offsets[s] = walk;
+    }
+
+    // The last point is the next border's first, so it is left out
+    for (int i = 0; i < steps; i++) {
+        int s = reverse ? steps - i : i;
+        float t = (float)s / steps;
+        fprintf(file, "%s[%.5f,%.5f]", *first ? "" : ",", x0 + dx * t + nx * offsets[s], y0 + dy * t + ny * offsets[s]);
+        *first = false;
+    }
+    free(offsets);
+}
+
+// Writes a world of cols x rows countries whose borders are shared exactly,
+// like real country outlines, and whose vertex count grows with edgeSteps
+static bool generateDataset(const Dataset* dataset) {
+    FILE* file = fopen(dataset->path, "wb");
+    if (!file) return false;
+
+    float width = 360.0f / dataset->cols, height = 160.0f / dataset->rows;
+    fprintf(file, "{\"type\":\"FeatureCollection\",\"features\":[");
+    for (int i = 0; i < dataset->cols; i++) {
+        for (int j = 0; j < dataset->rows; j++) {
+            int index = i * dataset->rows + j;
+            float left = -180.0f + i * width, right = left + width;
+            float bottom = -80.0f + j * height, top = bottom + height;
+            unsigned int seedBottom = 1 + 2 * (i * (dataset->rows + 1) + j);
+            unsigned int seedTop = 1 + 2 * (i * (dataset->rows + 1) + j + 1);
+            unsigned int seedLeft = 2 + 2 * (i * dataset->rows + j);
+            unsigned int seedRight = 2 + 2 * ((i + 1) * dataset->rows + j);
+            int steps = dataset->edgeSteps;
+
+            fprintf(file, "%s{\"type\":\"Feature\",\"properties\":{\"name\":\"Country %d\",\"iso_a2\":\"%c%c\"},"
+                          "\"geometry\":{\"type\":\"Polygon\",\"coordinates\":[[",
+                    index > 0 ? "," : "", index, 'A' + index / 26 % 26, 'A' + index % 26);
+            bool first = true;
+            writeBorder(file, left, bottom, right, bottom, steps, j > 0, seedBottom, false, &first);
+            writeBorder(file, right, bottom, right, top, steps, i < dataset->cols - 1, seedRight, false, &first);
+            writeBorder(file, left, top, right, top, steps, j < dataset->rows - 1, seedTop, true, &first);
+            writeBorder(file, left, bottom, left, top, steps, i > 0, seedLeft, true, &first);
+            fprintf(file, ",[%.5f,%.5f]]]}}", left, bottom);
+        }
+    }
+    fprintf(file, "]}\n");
+    return fclose(file) == 0;
+}
+
+// Scripted camera: whole world, a pan across at 3x, then a dive to 25x
+static void cameraAt(int frame, float* zoom, Vector2* offset) {
+    float t = (float)frame / (BENCH_PATH_FRAMES - 1);
+    float lon, lat;
+    if (t < 0.25f) {
+        *zoom = 1.0f;
+        lon = 0.0f;
+        lat = 0.0f;
+    } else if (t < 0.6f) {
+        *zoom = 3.0f;
+        lon = -150.0f + (t - 0.25f) / 0.35f * 300.0f;
+        lat = 20.0f;
+    } else {
+        *zoom = 3.0f * powf(25.0f / 3.0f, (t - 0.6f) / 0.4f);
+        lon = 10.0f;
+        lat = 48.0f;
+    }
+    offset->x = SCREEN_WIDTH / 2.0f - (lon + 180.0f) * (SCREEN_WIDTH / 360.0f) * *zoom;
+    offset->y = SCREEN_HEIGHT / 2.0f - (90.0f - lat) * (SCREEN_HEIGHT / 180.0f) * *zoom;
+}
+
+static Rectangle viewBounds(const WorldMap* map) {
+    float leftLon = screenXToLongitude(0, map->zoom, map->offset.x);
+    float rightLon = screenXToLongitude(SCREEN_WIDTH, map->zoom, map->offset.x);
+    float topLat = screenYToLatitude(0, map->zoom, map->offset.y);
+    float bottomLat = screenYToLatitude(SCREEN_HEIGHT, map->zoom, map->offset.y);
+    return (Rectangle){ leftLon, bottomLat, rightLon - leftLon, topLat - bottomLat };
+}
+
+static void benchLoading(Report* r, const Dataset* dataset, int samples) {
+    Timer timer = { 0 };
+
+    for (int s = 0; s < samples; s++) {
+        timerStart(&timer);
+        WorldMap* map = loadWorldMapGeoJSON(dataset->path);
+        timerStop(&timer);
+        unloadWorldMap(map);
+    }
+    report(r, "load_geojson", dataset->name, 0, &timer);
+
+    for (int s = 0; s < samples; s++) {
+        timerStart(&timer);
+        WorldMap* map = loadWorldMapParson(dataset->path);
+        timerStop(&timer);
+        unloadWorldMap(map);
+    }
+    report(r, "load_parson", dataset->name, 0, &timer);
+
+    // Full startup path, GeoJSON fallback and then the compiled file
+    Timer unloadTimer = { 0 };
+    for (int s = 0; s < samples; s++) {
+        timerStart(&timer);
+        WorldMap* map = loadWorldMap(dataset->path);
+        timerStop(&timer);
+        timerStart(&unloadTimer);
+        unloadWorldMap(map);
+        timerStop(&unloadTimer);
+    }
+    report(r, "load_world", dataset->name, 0, &timer);
+    report(r, "unload", dataset->name, 0, &unloadTimer);
+
+    char compiledPath[512];
+    getMapFilePath(dataset->path, compiledPath, sizeof(compiledPath));
+    WorldMap* source = loadWorldMapGeoJSON(dataset->path);
+    bool saved = source && saveWorldMapFile(source, compiledPath, dataset->path);
+    unloadWorldMap(source);
+    if (!saved) return;
+
+    for (int s = 0; s < samples; s++) {
+        timerStart(&timer);
+        WorldMap* map = loadWorldMap(dataset->path);
+        timerStop(&timer);
+        unloadWorldMap(map);
+    }
+    report(r, "load_compiled", dataset->name, 0, &timer);
+    remove(compiledPath);
+}
+
+static long fileSize(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? (long)info.st_size : 0;
+}
+
+// The path the web bundle takes to its first frame: compiled map, saved
+// statuses, then one full view, rasterized here for want of a window. The
+// param is the bytes read from disk, the native stand-in for the download.
+static void benchStartup(Report* r, const Dataset* dataset, int samples) {
+    char compiledPath[512], statusPath[600];
+    getMapFilePath(dataset->path, compiledPath, sizeof(compiledPath));
+    snprintf(statusPath, sizeof(statusPath), "%s.statuses.dat", dataset->path);
+
+    WorldMap* source = loadWorldMapGeoJSON(dataset->path);
+    bool saved = source && saveWorldMapFile(source, compiledPath, dataset->path);
+    if (saved) {
+        CountryStatusList* list = (CountryStatusList*)calloc(1, sizeof(CountryStatusList));
+        for (int c = 0; c < source->countryCount; c += 3) {
+            UpdateCountryStatus(list, source->countries[c].iso_code, 1 + c % 3);
+        }
+        SaveCountryStatuses(statusPath, list);
+        free(list->statuses);
+        free(list);
+    }
+    unloadWorldMap(source);
+    if (!saved) return;
+
+    int bytes = (int)(fileSize(compiledPath) + fileSize(statusPath));
+    ThreadPool* pool = createThreadPool(0);
+    RasterView view = { SCREEN_WIDTH, SCREEN_HEIGHT, { 0.0f, 0.0f }, 1.0f, false };
+    Timer mapTimer = { 0 }, statusTimer = { 0 }, frameTimer = { 0 }, totalTimer = { 0 };
+
+    for (int s = 0; s < samples; s++) {
+        timerStart(&totalTimer);
+        timerStart(&mapTimer);
+        WorldMap* map = loadWorldMap(dataset->path);
+        timerStop(&mapTimer);
+
+        timerStart(&statusTimer);
+        CountryStatusList* list = LoadCountryStatuses(statusPath);
+        timerStop(&statusTimer);
+
+        timerStart(&frameTimer);
+        RasterContext* context = createRasterContext(map, getThreadPoolSize(pool));
+        Image image = { 0 };
+        renderMapImage(context, list, view, pool, &image);
+        timerStop(&frameTimer);
+        timerStop(&totalTimer);
+
+        free(image.data);
+        destroyRasterContext(context);
+        free(list->statuses);
+        free(list);
+        unloadWorldMap(map);
+    }
+    report(r, "startup_map", dataset->name, bytes, &mapTimer);
+    report(r, "startup_statuses", dataset->name, bytes, &statusTimer);
+    report(r, "startup_frame", dataset->name, bytes, &frameTimer);
+    report(r, "startup_total", dataset->name, bytes, &totalTimer);
+
+    destroyThreadPool(pool);
+    remove(compiledPath);
+    remove(statusPath);
+}
+
+static void benchView(Report* r, const Dataset* dataset) {
+    WorldMap* map = loadWorldMap(dataset->path);
+    if (!map) return;
+
+    Timer cull = { 0 }, project = { 0 }, pick = { 0 };
+    long visibleTotal = 0;
+    int picked = 0;
+    unsigned int seed = 12345;
+
+    for (int frame = 0; frame < BENCH_PATH_FRAMES; frame++) {
+        cameraAt(frame, &map->zoom, &map->offset);
+
+        timerStart(&cull);
+        int visibleCount = querySpatialGrid(map->spatialIndex, viewBounds(map), map->visiblePolygons);
+        timerStop(&cull);
+        visibleTotal += visibleCount;
+
+        // The CPU side of drawWorldMap: cull, pick a level and project
+        timerStart(&project);
+        visibleCount = querySpatialGrid(map->spatialIndex, viewBounds(map), map->visiblePolygons);
+        const MapLevel* level = &map->levels[selectMapLevel(map, map->zoom)];
+        MapCamera camera = getMapCamera(map->zoom, map->offset);
+        for (int v = 0; v < visibleCount; v++) {
+            int i = map->visiblePolygons[v];
+            projectPoints(camera, getLevelPoints(level, i), map->screenPoints, level->polygons[i].numPoints);
+        }
+        timerStop(&project);
+
+        timerStart(&pick);
+        for (int p = 0; p < BENCH_PICKS_PER_FRAME; p++) {
+            seed = seed * 1664525u + 1013904223u;
+            Vector2 position = { (float)(seed >> 8) / (1u << 24) * SCREEN_WIDTH, (float)(seed & 0xffff) / 65536.0f * SCREEN_HEIGHT };
+            if (pickCountryAt(map, position) >= 0) picked++;
+        }
+        timerStop(&pick);
+    }
+
+    report(r, "cull", dataset->name, (int)(visibleTotal / BENCH_PATH_FRAMES), &cull);
+    report(r, "cull_project", dataset->name, 0, &project);
+    report(r, "pick", dataset->name, BENCH_PICKS_PER_FRAME, &pick);
+    fprintf(stderr, "  %d of %d picks hit a country\n", picked, BENCH_PATH_FRAMES * BENCH_PICKS_PER_FRAME);
+    unloadWorldMap(map);
+}
+
+// Bulk projection of every full-detail point: the per-point functions
+// against each kernel compiled in and supported here
+static void benchProjection(Report* r, const Dataset* dataset) {
+    WorldMap* map = loadWorldMap(dataset->path);
+    if (!map) return;
+
+    const Vector2* points = map->levels[0].points;
+    int count = map->levels[0].numPoints;
+    Vector2* reference = (Vector2*)malloc(sizeof(Vector2) * (count > 0 ? count : 1));
+    Vector2* out = (Vector2*)malloc(sizeof(Vector2) * (count > 0 ? count : 1));
+    float zoom = 3.0f;
+    Vector2 offset = { -1200.0f, -400.0f };
+    const int samples = 50;
+
+    Timer timer = { 0 };
+    for (int s = 0; s < samples; s++) {
+        timerStart(&timer);
+        for (int j = 0; j < count; j++) {
+            reference[j] = (Vector2){
+                longitudeToScreenX(points[j].x, zoom, offset.x),
+                latitudeToScreenY(points[j].y, zoom, offset.y)
+            };
+        }
+        timerStop(&timer);
+    }
+    reportItems(r, "project_functions", dataset->name, count, &timer, count);
+
+    ProjectionKernel previous = getProjectionKernel();
+    MapCamera camera = getMapCamera(zoom, offset);
+    for (int k = PROJECTION_KERNEL_SCALAR; k < PROJECTION_KERNEL_COUNT; k++) {
+        if (!setProjectionKernel((ProjectionKernel)k)) continue;
+        for (int s = 0; s < samples; s++) {
+            timerStart(&timer);
+            projectPoints(camera, points, out, count);
+            timerStop(&timer);
+        }
+
+        float maxError = 0.0f;
+        for (int j = 0; j < count; j++) {
+            maxError = fmaxf(maxError, fmaxf(fabsf(out[j].x - reference[j].x), fabsf(out[j].y - reference[j].y)));
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "project_%s", getProjectionKernelName((ProjectionKernel)k));
+        reportItems(r, name, dataset->name, count, &timer, count);
+        fprintf(stderr, "  max difference to the per-point functions: %g px\n", maxError);
+    }
+    setProjectionKernel(previous);
+
+    free(reference);
+    free(out);
+    unloadWorldMap(map);
+}
+
+static void benchStatuses(Report* r, const Dataset* dataset) {
+    WorldMap* map = loadWorldMap(dataset->path);
+    if (!map) return;
+
+    const int sizes[] = { 16, 128, ISO_KEY_COUNT };
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        CountryStatusList* list = (CountryStatusList*)calloc(1, sizeof(CountryStatusList));
+        for (int i = 0; i < sizes[s]; i++) {
+            char iso[3] = { (char)('a' + i / 26 % 26), (char)('a' + i % 26), '\0' };
+            UpdateCountryStatus(list, iso, 1 + i % 3);
+        }
+
+        Timer timer = { 0 };
+        volatile int sink = 0;
+        for (int sample = 0; sample < 100; sample++) {
+            timerStart(&timer);
+            for (int c = 0; c < map->countryCount; c++) {
+                sink += GetCountryStatus(list, map->countries[c].iso_code);
+            }
+            timerStop(&timer);
+        }
+        report(r, "status_lookup", dataset->name, sizes[s], &timer);
+
+        for (int sample = 0; sample < 100; sample++) {
+            timerStart(&timer);
+            for (int c = 0; c < map->countryCount; c++) {
+                UpdateCountryStatus(list, map->countries[c].iso_code, sample % 4);
+            }
+            timerStop(&timer);
+        }
+        report(r, "status_update", dataset->name, sizes[s], &timer);
+        (void)sink;
+
+        free(list->statuses);
+        free(list);
+    }
+    unloadWorldMap(map);
+}
+
+// Needs a display: draws the scripted path with the CPU polygon renderer
+static void benchDrawing(Report* r, const Dataset* dataset) {
+    WorldMap* map = loadWorldMap(dataset->path);
+    if (!map) return;
+
+    CountryStatusList* list = (CountryStatusList*)calloc(1, sizeof(CountryStatusList));
+    Timer timer = { 0 };
+    for (int frame = 0; frame < BENCH_PATH_FRAMES; frame++) {
+        cameraAt(frame, &map->zoom, &map->offset);
+        BeginDrawing();
+        ClearBackground(SPACE_BG_COLOR);
+        timerStart(&timer);
+        drawWorldMap(map, -1, list);
+        timerStop(&timer);
+        EndDrawing();
+    }
+    report(r, "draw_cpu", dataset->name, 0, &timer);
+
+    free(list);
+    unloadWorldMap(map);
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = NULL;
+    const char* workDir = "build/bench";
+    int samples = 3;
+    bool gl = false;
+    Dataset datasets[BENCH_MAX_DATASETS];
+    int datasetCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) samples = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--work") == 0 && i + 1 < argc) workDir = argv[++i];
+        else if (strcmp(argv[i], "--gl") == 0) gl = true;
+        else if (strcmp(argv[i], "--dataset") == 0 && i + 1 < argc && datasetCount < BENCH_MAX_DATASETS) {
+            const char* name = argv[++i];
+            Dataset* dataset = &datasets[datasetCount++];
+            memset(dataset, 0, sizeof(*dataset));
+            dataset->name = name;
+            if (strcmp(name, "small") == 0) {
+                *dataset = (Dataset){ "small", "", 24, 12, 32 };
+            } else if (strcmp(name, "large") == 0) {
+                *dataset = (Dataset){ "large", "", 26, 26, 400 };
+            } else {
+                snprintf(dataset->path, sizeof(dataset->path), "%s", name);
+            }
+        } else {
+            printf("Usage: %s [--out file.json] [--samples N] [--work dir] [--gl] [--dataset small|large|path]...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (samples < 1) samples = 1;
+    if (datasetCount == 0) {
+        datasets[datasetCount++] = (Dataset){ "small", "", 24, 12, 32 };
+        datasets[datasetCount++] = (Dataset){ "large", "", 26, 26, 400 };
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    mkdir("build", 0755);
+    mkdir(workDir, 0755);
+
+    for (int d = 0; d < datasetCount; d++) {
+        Dataset* dataset = &datasets[d];
+        if (dataset->cols == 0) continue;
+        snprintf(dataset->path, sizeof(dataset->path), "%s/%s.geojson", workDir, dataset->name);
+        if (!generateDataset(dataset)) {
+            printf("Failed to write dataset: %s\n", dataset->path);
+            return 1;
+        }
+    }
+
+    Report r = { outPath ? fopen(outPath, "w") : stdout, true };
+    if (!r.out) {
+        printf("Failed to open %s\n", outPath);
+        return 1;
+    }
+
+    fprintf(r.out, "{\n  \"datasets\": [");
+    for (int d = 0; d < datasetCount; d++) {
+        WorldMap* map = loadWorldMapGeoJSON(datasets[d].path);
+        fprintf(r.out, "%s\n    { \"name\": \"%s\", \"path\": \"%s\", \"countries\": %d, \"polygons\": %d, \"points\": %d }",
+                d > 0 ? "," : "", datasets[d].name, datasets[d].path,
+                map ? map->countryCount : 0, map ? map->numPolygons : 0, map ? map->numPoints : 0);
+        unloadWorldMap(map);
+    }
+    fprintf(r.out, "\n  ],\n  \"results\": [");
+
+    if (gl) {
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Traveltint bench");
+    }
+
+    for (int d = 0; d < datasetCount; d++) {
+        benchLoading(&r, &datasets[d], samples);
+        benchStartup(&r, &datasets[d], samples);
+        benchView(&r, &datasets[d]);
+        benchProjection(&r, &datasets[d]);
+        benchStatuses(&r, &datasets[d]);
+        if (gl) benchDrawing(&r, &datasets[d]);
+    }
+
+    if (gl) CloseWindow();
+
+    fprintf(r.out, "\n  ]\n}\n");
+    if (outPath) fclose(r.out);
+    return 0;
+}
@@ -0,0 +1,38 @@
+// Compiles a GeoJSON world into the binary map format read by loadWorldMap,
+// then verifies the written file in full.
+// Usage: map_compiler <input.geojson> <output.ttmap>
+//        map_compiler --verify <file.ttmap>
+#include "map_utils.h"
+#include "map_file.h"
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "--verify") == 0) {
+        bool ok = verifyWorldMapFile(argv[2]);
+        printf("%s: %s\n", argv[2], ok ? "ok" : "corrupt");
+        return ok ? 0 : 1;
+    }
+    if (argc != 3) {
+        printf("Usage: %s input.geojson output%s\n", argv[0], MAP_FILE_EXTENSION);
+        printf("       %s --verify file%s\n", argv[0], MAP_FILE_EXTENSION);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    WorldMap* map = loadWorldMapGeoJSON(argv[1]);
+    if (!map) return 1;
+
+    bool ok = saveWorldMapFile(map, argv[2], argv[1]);
+    if (ok && !verifyWorldMapFile(argv[2])) {
+        printf("Verification of %s failed\n", argv[2]);
+        ok = false;
+    }
+    if (ok) {
+        printf("Compiled %d countries, %d polygons into %s\n", map->countryCount, map->numPolygons, argv[2]);
+    }
+
+    unloadWorldMap(map);
+    return ok ? 0 : 1;
+}